@@ -0,0 +1,259 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "bitsliced_evaluation.hh"
+
+
+using namespace std;
+
+
+// arithmetic in F_3 on pairs of masks of the lanes that equal 1 and 2
+
+static inline
+void
+add_f3(
+    uint64_t & a_ones,
+    uint64_t & a_twos,
+    uint64_t b_ones,
+    uint64_t b_twos
+    )
+{
+  uint64_t a_zeros = ~(a_ones | a_twos);
+  uint64_t b_zeros = ~(b_ones | b_twos);
+  uint64_t ones = (a_ones & b_zeros) | (a_zeros & b_ones) | (a_twos & b_twos);
+  uint64_t twos = (a_twos & b_zeros) | (a_zeros & b_twos) | (a_ones & b_ones);
+  a_ones = ones;
+  a_twos = twos;
+}
+
+// add m b for a constant m
+static inline
+void
+add_scaled_f3(
+    uint64_t & a_ones,
+    uint64_t & a_twos,
+    uint8_t m,
+    uint64_t b_ones,
+    uint64_t b_twos
+    )
+{
+  if ( m == 1 )
+    add_f3(a_ones, a_twos, b_ones, b_twos);
+  else if ( m == 2 )
+    add_f3(a_ones, a_twos, b_twos, b_ones);
+}
+
+
+BitslicedEvaluation::
+BitslicedEvaluation(
+    unsigned int prime_exponent,
+    const LogarithmTable & logarithms
+    ) :
+  prime_exponent( prime_exponent ),
+  prime_power( logarithms.size() )
+{
+  if ( prime_exponent == 0 || prime_exponent > max_prime_exponent ) {
+    cerr << "BitslicedEvaluation: prime exponent out of range: " << prime_exponent << endl;
+    throw;
+  }
+
+  unsigned int prime_power_pred = this->prime_power - 1;
+
+  this->labels.resize(this->prime_power);
+  for ( uint32_t lx = 0; lx < this->prime_power; ++lx )
+    this->labels[logarithms[lx]] = lx;
+
+  // the label of T is 3, and the one of T^0 is 1
+  auto power_of_generator = [&] (uint64_t ex)
+    {
+      if ( ex == 0 )
+        return this->coefficients(1);
+      return this->coefficients(this->labels[(ex * logarithms[3]) % prime_power_pred]);
+    };
+
+  for ( unsigned int ix = 0; ix + 1 < prime_exponent; ++ix )
+    this->reduction_rows.push_back(power_of_generator(prime_exponent + ix));
+  for ( unsigned int ix = 0; ix < prime_exponent; ++ix )
+    this->frobenius_columns.push_back(power_of_generator(3 * ix));
+}
+
+vector<uint8_t>
+BitslicedEvaluation::
+coefficients(
+    uint32_t label
+    ) const
+{
+  vector<uint8_t> coeffs(this->prime_exponent);
+  for ( size_t ix = 0; ix < this->prime_exponent; ++ix, label /= 3 )
+    coeffs[ix] = label % 3;
+  return coeffs;
+}
+
+void
+BitslicedEvaluation::
+broadcast(
+    uint32_t label,
+    Element & a
+    ) const
+{
+  for ( size_t ix = 0; ix < this->prime_exponent; ++ix, label /= 3 ) {
+    a.ones[ix] = label % 3 == 1 ? ~(uint64_t)0 : 0;
+    a.twos[ix] = label % 3 == 2 ? ~(uint64_t)0 : 0;
+  }
+}
+
+uint64_t
+BitslicedEvaluation::
+lanes(
+    uint32_t label_begin,
+    Element & x
+    ) const
+{
+  for ( size_t ix = 0; ix < this->prime_exponent; ++ix ) {
+    x.ones[ix] = 0;
+    x.twos[ix] = 0;
+  }
+
+  uint64_t is_valid = 0;
+  for ( uint32_t lx = 0; lx < 64 && label_begin + lx < this->prime_power; ++lx ) {
+    uint64_t lane = (uint64_t)1 << lx;
+    if ( label_begin + lx != 0 )
+      is_valid |= lane;
+
+    uint32_t label = label_begin + lx;
+    for ( size_t ix = 0; ix < this->prime_exponent; ++ix, label /= 3 )
+      if ( label % 3 == 1 )
+        x.ones[ix] |= lane;
+      else if ( label % 3 == 2 )
+        x.twos[ix] |= lane;
+  }
+
+  return is_valid;
+}
+
+void
+BitslicedEvaluation::
+add(
+    Element & a,
+    const Element & b
+    ) const
+{
+  for ( size_t ix = 0; ix < this->prime_exponent; ++ix )
+    add_f3(a.ones[ix], a.twos[ix], b.ones[ix], b.twos[ix]);
+}
+
+void
+BitslicedEvaluation::
+multiply(
+    const Element & a,
+    const Element & b,
+    Element & c
+    ) const
+{
+  unsigned int r = this->prime_exponent;
+
+  uint64_t product_ones[2*max_prime_exponent - 1] = {};
+  uint64_t product_twos[2*max_prime_exponent - 1] = {};
+  for ( size_t ix = 0; ix < r; ++ix )
+    for ( size_t jx = 0; jx < r; ++jx ) {
+      uint64_t ones = (a.ones[ix] & b.ones[jx]) | (a.twos[ix] & b.twos[jx]);
+      uint64_t twos = (a.ones[ix] & b.twos[jx]) | (a.twos[ix] & b.ones[jx]);
+      add_f3(product_ones[ix+jx], product_twos[ix+jx], ones, twos);
+    }
+
+  // the rows give T^(r+i) in the basis, so that no carries occur
+  for ( size_t ix = 0; ix + 1 < r; ++ix )
+    for ( size_t kx = 0; kx < r; ++kx )
+      add_scaled_f3( product_ones[kx], product_twos[kx], this->reduction_rows[ix][kx],
+                     product_ones[r+ix], product_twos[r+ix] );
+
+  for ( size_t ix = 0; ix < r; ++ix ) {
+    c.ones[ix] = product_ones[ix];
+    c.twos[ix] = product_twos[ix];
+  }
+}
+
+void
+BitslicedEvaluation::
+frobenius(
+    const Element & a,
+    Element & b
+    ) const
+{
+  // Frobenius is F_3 linear and (c T^i)^3 = c (T^i)^3 for c in F_3
+  for ( size_t kx = 0; kx < this->prime_exponent; ++kx ) {
+    b.ones[kx] = 0;
+    b.twos[kx] = 0;
+  }
+  for ( size_t ix = 0; ix < this->prime_exponent; ++ix )
+    for ( size_t kx = 0; kx < this->prime_exponent; ++kx )
+      add_scaled_f3(b.ones[kx], b.twos[kx], this->frobenius_columns[ix][kx], a.ones[ix], a.twos[ix]);
+}
+
+tuple<unsigned int,unsigned int>
+BitslicedEvaluation::
+count(
+    const vector<unsigned int> & poly_coeff_exponents
+    ) const
+{
+  vector<Element> coeffs(poly_coeff_exponents.size());
+  for ( size_t dx = 0; dx < poly_coeff_exponents.size(); ++dx )
+    this->broadcast(this->labels[poly_coeff_exponents[dx]], coeffs[dx]);
+
+  unsigned int nmb_unramified = 0;
+  unsigned int nmb_ramified = 0;
+
+  Element x, f, tmp, conjugate, norm;
+  for ( uint32_t label_begin = 0; label_begin < this->prime_power; label_begin += 64 ) {
+    uint64_t is_valid = this->lanes(label_begin, x);
+
+    // Horner's scheme
+    f = coeffs.back();
+    for ( size_t dx = coeffs.size() - 1; dx-- > 0; ) {
+      this->multiply(f, x, tmp);
+      this->add(tmp, coeffs[dx]);
+      f = tmp;
+    }
+
+    // the norm is contained in F_3, which is the lowest coefficient
+    norm = f;
+    conjugate = f;
+    for ( size_t ix = 1; ix < this->prime_exponent; ++ix ) {
+      this->frobenius(conjugate, tmp);
+      conjugate = tmp;
+      this->multiply(norm, conjugate, tmp);
+      norm = tmp;
+    }
+
+    nmb_unramified += 2 * __builtin_popcountll(norm.ones[0] & is_valid);
+    nmb_ramified += __builtin_popcountll(~(norm.ones[0] | norm.twos[0]) & is_valid);
+  }
+
+  return make_tuple(nmb_unramified, nmb_ramified);
+}
@@ -0,0 +1,84 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+
+#ifndef _H_BITSLICED_EVALUATION
+#define _H_BITSLICED_EVALUATION
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "logarithm_table.hh"
+
+
+using std::tuple;
+using std::vector;
+
+
+// Evaluation over F_q, q = 3^r, at 64 values of x at once using only bitwise
+// operations. An element of F_3 for all 64 lanes is a pair of masks, the
+// lanes in which it equals 1 and those in which it equals 2, and an element
+// of F_q is given by r such pairs, one for each coefficient with respect to
+// the polynomial basis. The quadratic character of y is its norm
+// y y^3 ... y^(3^(r-1)) in F_3, where Frobenius is applied as a linear map.
+class BitslicedEvaluation
+{
+  public:
+    static const unsigned int max_prime_exponent = 20;
+
+    // the logarithms are given as ReductionTable::logarithm_table
+    BitslicedEvaluation(unsigned int prime_exponent, const LogarithmTable & logarithms);
+
+    // the numbers of unramified and ramified points with x != 0, infty
+    tuple<unsigned int,unsigned int> count(const vector<unsigned int> & poly_coeff_exponents) const;
+
+  private:
+    struct Element
+    {
+      uint64_t ones[max_prime_exponent];
+      uint64_t twos[max_prime_exponent];
+    };
+
+    const unsigned int prime_exponent;
+    const unsigned int prime_power;
+
+    // the label sum_i c_i 3^i of a^j, where j = q-1 refers to 0
+    vector<uint32_t> labels;
+    // the coefficients of T^(r+i) for i < r-1, where T generates the basis
+    vector<vector<uint8_t>> reduction_rows;
+    // the coefficients of (T^i)^3 for i < r
+    vector<vector<uint8_t>> frobenius_columns;
+
+    vector<uint8_t> coefficients(uint32_t label) const;
+
+    void broadcast(uint32_t label, Element & a) const;
+    uint64_t lanes(uint32_t label_begin, Element & x) const;
+
+    void add(Element & a, const Element & b) const;
+    void multiply(const Element & a, const Element & b, Element & c) const;
+    void frobenius(const Element & a, Element & b) const;
+};
+
+#endif
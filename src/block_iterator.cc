@@ -150,6 +150,50 @@ as_position()
   return position;
 }
 
+bool
+BlockIterator::
+contains(
+    const vector<unsigned int> & position
+    )
+  const
+{
+  if ( position.size() != this->length_ )
+    return false;
+
+  for ( auto & blocks_it : this->blocks ) {
+    unsigned int c = position[blocks_it.first];
+    if ( c < get<0>(blocks_it.second) || c >= get<1>(blocks_it.second) )
+      return false;
+  }
+
+  for ( auto & set_it : this->sets )
+    if ( find(set_it.second.cbegin(), set_it.second.cend(), position[set_it.first])
+         == set_it.second.cend() )
+      return false;
+
+  // dependent sets are indexed by the index of the coupled set or by the
+  // value of the coupled block
+  for ( auto & set_it : this->dependent_sets ) {
+    size_t ix = set_it.first;
+    size_t jx = get<0>(set_it.second);
+    auto & map_set = get<1>(set_it.second);
+
+    unsigned int key = position[jx];
+    auto sets_it = this->sets.find(jx);
+    if ( sets_it != this->sets.end() )
+      key = find(sets_it->second.cbegin(), sets_it->second.cend(), position[jx])
+            - sets_it->second.cbegin();
+
+    auto map_set_it = map_set.find(key);
+    if (    map_set_it == map_set.end()
+         || find(map_set_it->second.cbegin(), map_set_it->second.cend(), position[ix])
+            == map_set_it->second.cend() )
+      return false;
+  }
+
+  return true;
+}
+
 vector<tuple<unsigned int,unsigned int>>
 BlockIterator::
 as_block()
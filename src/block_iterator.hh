@@ -65,6 +65,8 @@ class BlockIterator
     bool inline is_end() const { return has_reached_end; };
 
     vector<unsigned int> as_position();
+    // whether the position is enumerated, ignoring the package size
+    bool contains(const vector<unsigned int> & position) const;
     vector<tuple<unsigned int,unsigned int>> as_block();
     BlockIterator as_block_enumerator();
 
@@ -39,10 +39,28 @@ operator<<(
   stream << "base field: " << config.prime << "^" << config.prime_exponent << "; ";
   stream << "genus: " << config.genus << "; ";
   stream << "with_marked_point: " << config.with_marked_point << "; ";
+  if ( config.projective_normalization )
+    stream << "projective_normalization: " << config.projective_normalization << "; ";
+  if ( config.galois_reduction )
+    stream << "galois_reduction: " << config.galois_reduction << "; ";
+  if ( config.factorization_patterns )
+    stream << "factorization_patterns: " << config.factorization_patterns << "; ";
+  if ( !config.ramification_types.empty() ) {
+    stream << "ramification_types:";
+    for ( const auto & ramification_type : config.ramification_types ) {
+      stream << " ";
+      for ( size_t ix = 0; ix < ramification_type.size(); ++ix )
+        stream << (ix == 0 ? "" : ",") << ramification_type[ix];
+    }
+    stream << "; ";
+  }
   if ( config.count_exponent != config.genus )
     stream << "count_exponent: " << config.count_exponent << "; ";
   stream << "result_path: " << config.result_path.generic_string() << "; ";
-  stream << "package_size: " << config.package_size << endl;
+  stream << "package_size: " << config.package_size;
+  if ( config.table_cache_size != ConfigNode::default_table_cache_size )
+    stream << "; table_cache_size: " << config.table_cache_size;
+  stream << endl;
 
   return stream;
 }
@@ -64,6 +82,14 @@ namespace YAML
 
     node["Genus"] = config.genus;
     node["WithMarkedPoint"] = config.with_marked_point;
+    if ( config.projective_normalization )
+      node["ProjectiveNormalization"] = config.projective_normalization;
+    if ( config.galois_reduction )
+      node["GaloisReduction"] = config.galois_reduction;
+    if ( config.factorization_patterns )
+      node["FactorizationPatterns"] = config.factorization_patterns;
+    for ( const auto & ramification_type : config.ramification_types )
+      node["RamificationTypes"].push_back(ramification_type);
 
     if ( config.count_exponent != config.genus )
       node["CountExponent"] = config.count_exponent;
@@ -71,6 +97,9 @@ namespace YAML
     node["ResultPath"] = config.result_path.generic_string();
   
     node["PackageSize"] = config.package_size;
+
+    if ( config.table_cache_size != ConfigNode::default_table_cache_size )
+      node["TableCacheSize"] = config.table_cache_size;
   
     return node;
   }
@@ -93,6 +122,22 @@ namespace YAML
   
     config.genus = node["Genus"].as<int>();
     config.with_marked_point = node["WithMarkedPoint"].as<bool>();
+    if ( node["ProjectiveNormalization"] )
+      config.projective_normalization = node["ProjectiveNormalization"].as<bool>();
+    else
+      config.projective_normalization = false;
+    if ( node["GaloisReduction"] )
+      config.galois_reduction = node["GaloisReduction"].as<bool>();
+    else
+      config.galois_reduction = false;
+    if ( node["FactorizationPatterns"] )
+      config.factorization_patterns = node["FactorizationPatterns"].as<bool>();
+    else
+      config.factorization_patterns = false;
+    config.ramification_types.clear();
+    if ( node["RamificationTypes"] )
+      for ( const auto & ramification_type : node["RamificationTypes"] )
+        config.ramification_types.insert(ramification_type.as<vector<unsigned int>>());
 
     if ( node["CountExponent"] )
       config.count_exponent = node["CountExponent"].as<int>();
@@ -102,6 +147,11 @@ namespace YAML
     config.result_path = path(node["ResultPath"].as<string>());
   
     config.package_size = node["PackageSize"].as<int>();
+
+    if ( node["TableCacheSize"] )
+      config.table_cache_size = node["TableCacheSize"].as<int>();
+    else
+      config.table_cache_size = ConfigNode::default_table_cache_size;
   
     return true;
   }
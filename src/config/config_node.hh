@@ -25,15 +25,21 @@
 #define _H_CONFIG_NODE
 
 #include <boost/filesystem.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/set.hpp>
 #include <ostream>
+#include <set>
 #include <string>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
 
 using boost::filesystem::path;
 using boost::filesystem::is_directory;
 using std::ostream;
+using std::set;
 using std::string;
+using std::vector;
 
 
 struct ConfigNode
@@ -43,6 +49,16 @@ struct ConfigNode
   
   unsigned int genus;
   bool with_marked_point;
+  // enumerate normal forms under PGL_2 instead of affine substitutions; the
+  // stored counts of single blocks differ, but not their totals
+  bool projective_normalization = false;
+  // count only one curve for each orbit of Frobenius on the coefficients
+  bool galois_reduction = false;
+  // enumerate right hand sides by the factorization patterns of
+  // FactorizationPatternIterator, optionally only those of the given
+  // ramification types
+  bool factorization_patterns = false;
+  set<vector<unsigned int>> ramification_types;
 
   unsigned int count_exponent;
   
@@ -50,6 +66,11 @@ struct ConfigNode
   
   unsigned int package_size;
 
+  // the memory in MiB of field and reduction tables that are retained between
+  // sections, so that sections over the same prime do not rebuild them
+  static const unsigned int default_table_cache_size = 1024;
+  unsigned int table_cache_size = default_table_cache_size;
+
 
   inline bool verify() const
   {
@@ -57,6 +78,8 @@ struct ConfigNode
              && genus != 0 && count_exponent != 0
              && (is_directory(result_path) || create_directories(result_path))
              && package_size != 0
+             && ( factorization_patterns || ramification_types.empty() )
+             && !( factorization_patterns && (projective_normalization || galois_reduction) )
            );
   };
 
@@ -85,6 +108,10 @@ namespace serialization {
 
     ar & config.genus;
     ar & config.with_marked_point;
+    ar & config.projective_normalization;
+    ar & config.galois_reduction;
+    ar & config.factorization_patterns;
+    ar & config.ramification_types;
 
     ar & config.count_exponent;
 
@@ -96,6 +123,7 @@ namespace serialization {
       config.result_path = path(result_path_str);
 
     ar & config.package_size;
+    ar & config.table_cache_size;
   }
 
 }}
@@ -0,0 +1,283 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "count_autotuner.hh"
+#include "evaluation_simd.hh"
+
+
+using namespace std;
+using boost::filesystem::path;
+using boost::filesystem::rename;
+using boost::filesystem::unique_path;
+
+
+mutex CountAutotuner::profile_mutex;
+bool CountAutotuner::is_profile_loaded = false;
+map<CountAutotuner::ProfileKey, CountAutotuner::ProfileChoice> CountAutotuner::profile;
+
+
+const char *
+CountAutotuner::
+count_variant_name(
+    CountVariant variant
+    )
+{
+  switch ( variant ) {
+    case CountVariantTables:       return "tables";
+    case CountVariantScalarTables: return "scalar tables";
+    case CountVariantPrimeField:   return "prime field";
+    case CountVariantBitsliced:    return "bitsliced";
+  }
+  return "unknown";
+}
+
+const char *
+CountAutotuner::
+block_count_implementation_name(
+    CurveBlockCountImplementation implementation
+    )
+{
+  switch ( implementation ) {
+    case CurveBlockCountImplementationTiled:       return "tiled";
+    case CurveBlockCountImplementationGrayCode:    return "gray code";
+    case CurveBlockCountImplementationCorrelation: return "correlation";
+    case CurveBlockCountImplementationSmallField:  return "small field";
+    case CurveBlockCountImplementationTuned:       return "tuned";
+  }
+  return "unknown";
+}
+
+void
+CountAutotuner::
+tune(
+    shared_ptr<FqElementTable> fq_table,
+    const vector<shared_ptr<ReductionTable>> & reduction_tables,
+    unsigned int degree
+    )
+{
+  if ( reduction_tables.empty() || reduction_tables.front()->is_opencl_enabled() )
+    return;
+
+  lock_guard<mutex> profile_lock(profile_mutex);
+
+  const char * profile_path = getenv("HYCU_COUNT_PROFILE");
+  if ( !is_profile_loaded && profile_path != nullptr )
+    load_profile(profile_path);
+  is_profile_loaded = true;
+
+
+  // blocks count with the choices of the tables, as in threads
+  CurveBlock curve_block( fq_table, synthetic_block(fq_table, degree),
+                          CurveBlockCountImplementationTuned );
+  bool is_profile_changed = false;
+
+  for ( auto reduction_table : reduction_tables ) {
+    // correlation falls back to Gray code over other fields than prime fields,
+    // and so do the kernels for small fields where there are none
+    vector<CurveBlockCountImplementation> implementations
+        { CurveBlockCountImplementationTiled, CurveBlockCountImplementationGrayCode };
+    if ( fq_table->is_prime_field() )
+      implementations.push_back(CurveBlockCountImplementationCorrelation);
+    if ( reduction_table->small_field_kernel )
+      implementations.push_back(CurveBlockCountImplementationSmallField);
+
+    ProfileKey key = make_tuple( reduction_table->prime, reduction_table->prime_exponent,
+                                 degree, (unsigned int)evaluation_simd() );
+
+    auto profile_it = profile.find(key);
+    if (  profile_it != profile.end()
+       && reduction_table->is_count_variant_available(get<0>(profile_it->second)) ) {
+      reduction_table->set_count_variant(get<0>(profile_it->second));
+      reduction_table->set_block_count_implementation(get<1>(profile_it->second));
+      cerr << "CountAutotuner: " << reduction_table->prime << "^" << reduction_table->prime_exponent
+           << " degree " << degree << ": " << count_variant_name(get<0>(profile_it->second))
+           << ", " << block_count_implementation_name(get<1>(profile_it->second))
+           << " from profile" << endl;
+    }
+    else {
+      ProfileChoice best_choice =
+          make_tuple(CountVariantTables, CurveBlockCountImplementationCorrelation);
+      double best_rate = 0;
+
+      for ( auto variant : { CountVariantTables, CountVariantScalarTables,
+                             CountVariantPrimeField, CountVariantBitsliced } ) {
+        if ( !reduction_table->is_count_variant_available(variant) )
+          continue;
+        reduction_table->set_count_variant(variant);
+
+        // the other variants count curve by curve, whatever the implementation
+        bool is_per_curve = variant == CountVariantPrimeField || variant == CountVariantBitsliced;
+        for ( auto implementation : implementations ) {
+          if ( is_per_curve && implementation != implementations.front() )
+            break;
+          // the kernels for small fields do not use the tables, so that both
+          // table variants would time the same code
+          if (  variant == CountVariantScalarTables
+             && implementation == CurveBlockCountImplementationSmallField )
+            continue;
+          reduction_table->set_block_count_implementation(implementation);
+
+          double rate = measure_rate(curve_block, *reduction_table);
+          cerr << "CountAutotuner: " << reduction_table->prime << "^" << reduction_table->prime_exponent
+               << " degree " << degree << ": " << count_variant_name(variant);
+          if ( !is_per_curve )
+            cerr << ", " << block_count_implementation_name(implementation);
+          cerr << " " << rate << " curves/s" << endl;
+
+          if ( rate > best_rate ) {
+            best_choice = make_tuple(variant, implementation);
+            best_rate = rate;
+          }
+        }
+      }
+
+      reduction_table->set_count_variant(get<0>(best_choice));
+      reduction_table->set_block_count_implementation(get<1>(best_choice));
+      profile[key] = best_choice;
+      is_profile_changed = true;
+      cerr << "CountAutotuner: " << reduction_table->prime << "^" << reduction_table->prime_exponent
+           << " degree " << degree << ": chose " << count_variant_name(get<0>(best_choice))
+           << ", " << block_count_implementation_name(get<1>(best_choice)) << endl;
+    }
+
+    // the next tables are timed with subfields counted, as in production
+    curve_block.count(*reduction_table);
+  }
+
+  if ( is_profile_changed && profile_path != nullptr )
+    save_profile(profile_path);
+}
+
+void
+CountAutotuner::
+load_profile(
+    const string & profile_path
+    )
+{
+  ifstream profile_file(profile_path);
+  unsigned int prime, prime_exponent, degree, simd, variant, implementation;
+  while ( profile_file >> prime >> prime_exponent >> degree >> simd >> variant >> implementation )
+    if ( variant <= CountVariantBitsliced && implementation < CurveBlockCountImplementationTuned )
+      profile[make_tuple(prime, prime_exponent, degree, simd)] =
+          make_tuple((CountVariant)variant, (CurveBlockCountImplementation)implementation);
+}
+
+void
+CountAutotuner::
+save_profile(
+    const string & profile_path
+    )
+{
+  // other processes may read or write the profile at the same time, so we
+  // write to a file of our own and move it into place
+  path tmp_path( profile_path + unique_path(".%%%%-%%%%-%%%%").native() );
+  boost::system::error_code error;
+
+  {
+    ofstream profile_file(tmp_path.native(), ios::trunc);
+    for ( const auto & entry : profile )
+      profile_file << get<0>(entry.first) << " " << get<1>(entry.first) << " "
+                   << get<2>(entry.first) << " " << get<3>(entry.first) << " "
+                   << (unsigned int)get<0>(entry.second) << " "
+                   << (unsigned int)get<1>(entry.second) << endl;
+    if ( !profile_file ) {
+      cerr << "CountAutotuner: could not write profile " << profile_path << endl;
+      boost::filesystem::remove(tmp_path, error);
+      return;
+    }
+  }
+
+  rename(tmp_path, path(profile_path), error);
+  if ( error ) {
+    cerr << "CountAutotuner: could not write profile " << profile_path << endl;
+    boost::filesystem::remove(tmp_path, error);
+  }
+}
+
+vuu_block
+CountAutotuner::
+synthetic_block(
+    shared_ptr<FqElementTable> fq_table,
+    unsigned int degree
+    )
+{
+  // As in blocks of the curve iterator, the constant coefficient runs
+  // through the whole field, so that Gray code and correlation share their
+  // work among as many curves as in production. Fixed coefficient exponents
+  // stem from a linear congruential sequence, with q-1 as the index of zero.
+  unsigned int prime_power = fq_table->prime_power;
+  uint32_t state = 1;
+
+  vuu_block block;
+  block.emplace_back(fq_table->block_complete());
+  for ( size_t dx = 1; dx <= degree; ++dx ) {
+    state = 1103515245 * state + 12345;
+    unsigned int c = (state >> 16) % (dx == degree ? fq_table->prime_power_pred : prime_power);
+    block.emplace_back(c, c+1);
+  }
+
+  return block;
+}
+
+double
+CountAutotuner::
+measure_rate(
+    const CurveBlock & curve_block,
+    ReductionTable & reduction_table
+    )
+{
+  // the best of several repetitions is least disturbed by other processes
+  const size_t nmb_repetitions = 5;
+  const chrono::duration<double> min_duration = chrono::milliseconds(2);
+
+  double best_rate = 0;
+  for ( size_t rx = 0; rx < nmb_repetitions; ++rx ) {
+    chrono::duration<double> duration(0);
+    size_t nmb_counted = 0;
+    while ( duration < min_duration ) {
+      auto curve_block_copy = curve_block;
+      auto start = chrono::steady_clock::now();
+      curve_block_copy.count(reduction_table);
+      duration += chrono::steady_clock::now() - start;
+      nmb_counted += curve_block_copy.size();
+    }
+
+    best_rate = max(best_rate, nmb_counted / duration.count());
+  }
+
+  return best_rate;
+}
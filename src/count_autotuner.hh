@@ -0,0 +1,85 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+
+#ifndef _H_COUNT_AUTOTUNER
+#define _H_COUNT_AUTOTUNER
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "block_iterator.hh"
+#include "curve_block.hh"
+#include "fq_element_table.hh"
+#include "reduction_table.hh"
+
+
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::tuple;
+using std::vector;
+
+
+// Calibration of the count variants and block count implementations of
+// reduction tables. Every available combination is timed by counting a
+// synthetic block as threads do, and the fastest one is set for the rest of
+// the run. Variants that count curve by curve are timed only once, since they
+// do not use the block implementation. Choices are cached for each field,
+// degree, and instruction set, and they are kept in a profile on disk if the
+// environment variable HYCU_COUNT_PROFILE names a file.
+class CountAutotuner
+{
+  public:
+    // the reduction tables must be given in ascending order, as they are
+    // counted, since counts over extensions use those over subfields
+    static void tune( shared_ptr<FqElementTable> fq_table,
+                      const vector<shared_ptr<ReductionTable>> & reduction_tables,
+                      unsigned int degree );
+
+    static const char * count_variant_name(CountVariant variant);
+    static const char * block_count_implementation_name(CurveBlockCountImplementation implementation);
+
+  private:
+    // prime, prime exponent, degree, and instruction set
+    typedef tuple<unsigned int,unsigned int,unsigned int,unsigned int> ProfileKey;
+    typedef tuple<CountVariant,CurveBlockCountImplementation> ProfileChoice;
+
+    static mutex profile_mutex;
+    static bool is_profile_loaded;
+    static map<ProfileKey, ProfileChoice> profile;
+
+    static void load_profile(const string & profile_path);
+    static void save_profile(const string & profile_path);
+
+    static vuu_block synthetic_block(shared_ptr<FqElementTable> fq_table, unsigned int degree);
+    static double measure_rate(const CurveBlock & curve_block, ReductionTable & reduction_table);
+};
+
+#endif
@@ -0,0 +1,419 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <array>
+#include <utility>
+
+#include "count_kernels.hh"
+
+
+using namespace std;
+
+
+// the smallest odd dx with nonzero coefficient, or poly_size if there is none
+static constexpr
+size_t
+first_odd_term(
+    size_t poly_size,
+    unsigned int support
+    )
+{
+  for ( size_t dx = 1; dx < poly_size; dx += 2 )
+    if ( support & (1u << dx) )
+      return dx;
+  return poly_size;
+}
+
+// the largest dx with nonzero coefficient, or 0 if there is none
+static constexpr
+size_t
+last_term(
+    size_t poly_size,
+    unsigned int support
+    )
+{
+  for ( size_t dx = poly_size; dx-- > 1; )
+    if ( support & (1u << dx) )
+      return dx;
+  return 0;
+}
+
+static inline
+void
+record_point(
+    unsigned int f,
+    unsigned int prime_power_pred,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  nmb_ramified += f == prime_power_pred;
+  nmb_unramified += 2 * ( f != prime_power_pred && !(f & 1) );
+}
+
+
+// The loops over dx have bounds that are known at compile time and are
+// completely unrolled, so that the tests against the support are resolved
+// by the compiler.
+
+template <size_t poly_size, unsigned int support>
+static
+void
+count_even_odd(
+    const unsigned int * poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  constexpr size_t first_odd = first_odd_term(poly_size, support);
+  unsigned int minus_one_exponent = prime_power_pred / 2;
+
+  unsigned int coeffs[poly_size];
+  for ( size_t dx = 0; dx < poly_size; ++dx )
+    coeffs[dx] = poly_coeff_exponents[dx];
+
+  for ( unsigned int x = begin; x < end; ++x ) {
+    unsigned int f_even = coeffs[0];
+    unsigned int f_odd = prime_power_pred;
+    unsigned int xpw = 0;
+    for ( size_t dx = 1; dx < poly_size; ++dx ) {
+      xpw = zech_table[xpw + x].reduction;
+      if ( support & (1u << dx) ) {
+        unsigned int term = zech_table[coeffs[dx] + xpw].reduction;
+        if ( dx == first_odd )
+          f_odd = term;
+        else if ( dx & 1 )
+          f_odd = add_exponents(f_odd, term, prime_power_pred, zech_table);
+        else
+          f_even = add_exponents(f_even, term, prime_power_pred, zech_table);
+      }
+    }
+
+    record_point( add_exponents(f_even, f_odd, prime_power_pred, zech_table),
+                  prime_power_pred, nmb_unramified, nmb_ramified );
+
+    unsigned int f_odd_negated = zech_table[f_odd + minus_one_exponent].reduction;
+    f_odd_negated = f_odd == prime_power_pred ? prime_power_pred : f_odd_negated;
+    record_point( add_exponents(f_even, f_odd_negated, prime_power_pred, zech_table),
+                  prime_power_pred, nmb_unramified, nmb_ramified );
+  }
+}
+
+template <size_t poly_size, unsigned int support>
+static
+void
+count_xs(
+    const unsigned int * poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int coeffs[poly_size];
+  for ( size_t dx = 0; dx < poly_size; ++dx )
+    coeffs[dx] = poly_coeff_exponents[dx];
+
+  for ( unsigned int ix = begin; ix < end; ++ix ) {
+    unsigned int x = xs[ix];
+    unsigned int f = coeffs[0];
+    unsigned int xpw = 0;
+    for ( size_t dx = 1; dx < poly_size; ++dx ) {
+      xpw = zech_table[xpw + x].reduction;
+      if ( support & (1u << dx) )
+        f = add_exponents( f, zech_table[coeffs[dx] + xpw].reduction,
+                           prime_power_pred, zech_table );
+    }
+
+    record_point(f, prime_power_pred, nmb_unramified, nmb_ramified);
+  }
+}
+
+template <size_t tail_size, unsigned int tail_support>
+static
+void
+count_tile(
+    unsigned int constant_exponent,
+    const unsigned int * tail_coeff_exponents,
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int coeffs[tail_size + 1];
+  for ( size_t tx = 0; tx < tail_size; ++tx )
+    coeffs[tx] = tail_coeff_exponents[tx];
+
+  for ( unsigned int xx = 0; xx < nmb_xs; ++xx ) {
+    const unsigned int * xpws_x = xpws + xx * tail_size;
+
+    unsigned int f = add_exponents(constant_exponent, prefix_values[xx], prime_power_pred, zech_table);
+    for ( size_t tx = 0; tx < tail_size; ++tx )
+      if ( tail_support & (1u << tx) )
+        f = add_exponents( f, zech_table[coeffs[tx] + xpws_x[tx]].reduction,
+                           prime_power_pred, zech_table );
+
+    record_point(f, prime_power_pred, nmb_unramified, nmb_ramified);
+  }
+}
+
+template <size_t poly_size, unsigned int support>
+static
+void
+evaluate_values(
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const unsigned int * poly_coeff_exponents,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table
+    )
+{
+  // powers of x beyond the last term are not needed
+  constexpr size_t last = last_term(poly_size, support);
+
+  unsigned int coeffs[poly_size];
+  for ( size_t dx = 0; dx < poly_size; ++dx )
+    coeffs[dx] = poly_coeff_exponents[dx];
+
+  for ( unsigned int ix = begin; ix < end; ++ix ) {
+    unsigned int x = xs ? xs[ix] : ix;
+    unsigned int f = add_exponents(constant_exponent, prefix_values[x], prime_power_pred, zech_table);
+    unsigned int xpw = 0;
+    for ( size_t dx = 1; dx <= last; ++dx ) {
+      xpw = zech_table[xpw + x].reduction;
+      if ( support & (1u << dx) )
+        f = add_exponents( f, zech_table[coeffs[dx] + xpw].reduction,
+                           prime_power_pred, zech_table );
+    }
+
+    values[ix] = f;
+  }
+}
+
+
+// The tables of specializations. For polynomials the leading coefficient is
+// nonzero, and only the supports of the coefficients 1, ..., poly_size - 2
+// enumerate the kernels. Positions of blocks may have zero leading
+// coefficients, so that values kernels are enumerated by the supports of
+// the coefficients 1, ..., poly_size - 1.
+
+template <size_t poly_size, size_t ... middle_supports>
+static
+const array<CountEvenOddKernel, sizeof...(middle_supports)> &
+even_odd_kernels(
+    index_sequence<middle_supports...>
+    )
+{
+  static const array<CountEvenOddKernel, sizeof...(middle_supports)> kernels =
+    {{ &count_even_odd<poly_size, (middle_supports << 1) | (1u << (poly_size-1))>... }};
+  return kernels;
+}
+
+template <size_t poly_size, size_t ... middle_supports>
+static
+const array<CountXsKernel, sizeof...(middle_supports)> &
+xs_kernels(
+    index_sequence<middle_supports...>
+    )
+{
+  static const array<CountXsKernel, sizeof...(middle_supports)> kernels =
+    {{ &count_xs<poly_size, (middle_supports << 1) | (1u << (poly_size-1))>... }};
+  return kernels;
+}
+
+template <size_t tail_size, size_t ... tail_supports>
+static
+const array<CountTileKernel, sizeof...(tail_supports)> &
+tile_kernels(
+    index_sequence<tail_supports...>
+    )
+{
+  static const array<CountTileKernel, sizeof...(tail_supports)> kernels =
+    {{ &count_tile<tail_size, tail_supports>... }};
+  return kernels;
+}
+
+template <size_t poly_size, size_t ... supports>
+static
+const array<EvaluateValuesKernel, sizeof...(supports)> &
+values_kernels(
+    index_sequence<supports...>
+    )
+{
+  static const array<EvaluateValuesKernel, sizeof...(supports)> kernels =
+    {{ &evaluate_values<poly_size, (supports << 1)>... }};
+  return kernels;
+}
+
+template <size_t poly_size>
+static inline
+CountEvenOddKernel
+even_odd_kernel(
+    unsigned int support
+    )
+{
+  return even_odd_kernels<poly_size>(make_index_sequence<1u << (poly_size-2)>())
+           [(support >> 1) & ((1u << (poly_size-2)) - 1)];
+}
+
+template <size_t poly_size>
+static inline
+CountXsKernel
+xs_kernel(
+    unsigned int support
+    )
+{
+  return xs_kernels<poly_size>(make_index_sequence<1u << (poly_size-2)>())
+           [(support >> 1) & ((1u << (poly_size-2)) - 1)];
+}
+
+template <size_t tail_size>
+static inline
+CountTileKernel
+tile_kernel(
+    unsigned int tail_support
+    )
+{
+  return tile_kernels<tail_size>(make_index_sequence<1u << tail_size>())[tail_support];
+}
+
+template <size_t poly_size>
+static inline
+EvaluateValuesKernel
+values_kernel(
+    unsigned int support
+    )
+{
+  return values_kernels<poly_size>(make_index_sequence<1u << (poly_size-1)>())
+           [(support >> 1) & ((1u << (poly_size-1)) - 1)];
+}
+
+
+unsigned int
+count_kernel_support(
+    const vector<unsigned int> & coeff_exponents,
+    unsigned int zero_index
+    )
+{
+  unsigned int support = 0;
+  for ( size_t dx = 0; dx < coeff_exponents.size(); ++dx )
+    if ( coeff_exponents[dx] != zero_index )
+      support |= 1u << dx;
+  return support;
+}
+
+CountEvenOddKernel
+count_even_odd_kernel(
+    size_t poly_size,
+    unsigned int support
+    )
+{
+  if ( poly_size < 2 || !(support & (1u << (poly_size-1))) )
+    return nullptr;
+
+  switch ( poly_size ) {
+    case 2: return even_odd_kernel<2>(support);
+    case 3: return even_odd_kernel<3>(support);
+    case 4: return even_odd_kernel<4>(support);
+    case 5: return even_odd_kernel<5>(support);
+    case 6: return even_odd_kernel<6>(support);
+    case 7: return even_odd_kernel<7>(support);
+    case 8: return even_odd_kernel<8>(support);
+    case 9: return even_odd_kernel<9>(support);
+    default: return nullptr;
+  }
+}
+
+CountXsKernel
+count_xs_kernel(
+    size_t poly_size,
+    unsigned int support
+    )
+{
+  if ( poly_size < 2 || !(support & (1u << (poly_size-1))) )
+    return nullptr;
+
+  switch ( poly_size ) {
+    case 2: return xs_kernel<2>(support);
+    case 3: return xs_kernel<3>(support);
+    case 4: return xs_kernel<4>(support);
+    case 5: return xs_kernel<5>(support);
+    case 6: return xs_kernel<6>(support);
+    case 7: return xs_kernel<7>(support);
+    case 8: return xs_kernel<8>(support);
+    case 9: return xs_kernel<9>(support);
+    default: return nullptr;
+  }
+}
+
+CountTileKernel
+count_tile_kernel(
+    size_t tail_size,
+    unsigned int tail_support
+    )
+{
+  switch ( tail_size ) {
+    case 0: return tile_kernel<0>(tail_support);
+    case 1: return tile_kernel<1>(tail_support);
+    case 2: return tile_kernel<2>(tail_support);
+    case 3: return tile_kernel<3>(tail_support);
+    case 4: return tile_kernel<4>(tail_support);
+    default: return nullptr;
+  }
+}
+
+EvaluateValuesKernel
+evaluate_values_kernel(
+    size_t poly_size,
+    unsigned int support
+    )
+{
+  switch ( poly_size ) {
+    case 1: return values_kernel<1>(support);
+    case 2: return values_kernel<2>(support);
+    case 3: return values_kernel<3>(support);
+    case 4: return values_kernel<4>(support);
+    case 5: return values_kernel<5>(support);
+    case 6: return values_kernel<6>(support);
+    case 7: return values_kernel<7>(support);
+    case 8: return values_kernel<8>(support);
+    case 9: return values_kernel<9>(support);
+    default: return nullptr;
+  }
+}
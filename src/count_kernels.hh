@@ -0,0 +1,117 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+
+#ifndef _H_COUNT_KERNELS
+#define _H_COUNT_KERNELS
+
+#include <cstdint>
+#include <vector>
+
+#include "reduction_table.hh"
+
+
+using std::vector;
+
+
+// Scalar count kernels that are specialized at compile time to the size of a
+// polynomial and to the set of its nonzero coefficients. The support has bit
+// dx set if the coefficient of x^dx is nonzero. Terms with zero coefficients
+// are compiled out, and the loop over the coefficients is unrolled. Kernels
+// are looked up once per polynomial, and a null pointer is returned if there
+// is no specialization, in which case the caller falls back to generic code.
+// The kernels use the compact Zech tables of ReductionTable.
+
+const size_t count_kernel_max_poly_size = 9;
+const size_t count_kernel_max_tail_size = 4;
+
+// evaluate at x = a^i and -x for begin <= i < end <= (q-1)/2,
+// as the generic code in Curve::count_cpu
+typedef void (*CountEvenOddKernel)(
+    const unsigned int * poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// evaluate at x = a^i for i in xs[begin], ..., xs[end-1]
+typedef void (*CountXsKernel)(
+    const unsigned int * poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// evaluate one curve of a tile in CurveBlock::count_cpu; the arguments are
+// as for evaluate_lanes_simd, but with a single constant and the
+// tail_size other coefficients given in tail_coeff_exponents
+typedef void (*CountTileKernel)(
+    unsigned int constant_exponent,
+    const unsigned int * tail_coeff_exponents,
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// evaluate the values at a position of a block in CurveBlock::count_gray_code
+// and count_correlation; the arguments are as for evaluate_values_simd, but
+// the support, whose bit 0 is ignored, determines the terms besides the
+// constant and the prefix values
+typedef void (*EvaluateValuesKernel)(
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const unsigned int * poly_coeff_exponents,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table
+    );
+
+unsigned int
+count_kernel_support(
+    const vector<unsigned int> & coeff_exponents,
+    unsigned int zero_index
+    );
+
+// the polynomial must have nonzero leading coefficient
+CountEvenOddKernel count_even_odd_kernel(size_t poly_size, unsigned int support);
+CountXsKernel count_xs_kernel(size_t poly_size, unsigned int support);
+CountTileKernel count_tile_kernel(size_t tail_size, unsigned int tail_support);
+// the coefficients of the polynomial may vanish
+EvaluateValuesKernel evaluate_values_kernel(size_t poly_size, unsigned int support);
+
+#endif
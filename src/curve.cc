@@ -34,6 +34,7 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -41,7 +42,9 @@
 #include <chrono>
 #endif
 
+#include "count_kernels.hh"
 #include "curve.hh"
+#include "evaluation_simd.hh"
 #include "opencl/interface.hh"
 #include "reduction_table.hh"
 
@@ -49,15 +52,21 @@
 using namespace std;
 
 
+const unsigned int Curve::min_chunk_size = 1 << 14;
+
 ostream&
 operator<<(
     ostream & stream,
     const Curve & curve
     )
 {
+  fq_nmod_t a;
+  fq_nmod_init(a, curve.table->fq_ctx);
+
   stream << "Y^2 = ";
   for (int ix=curve.poly_coeff_exponents.size()-1; ix>=0; --ix) {
-    auto coeff_str = fq_nmod_get_str_pretty(curve.table->at(curve.poly_coeff_exponents[ix]), curve.table->fq_ctx);
+    curve.table->element(a, curve.poly_coeff_exponents[ix]);
+    auto coeff_str = fq_nmod_get_str_pretty(a, curve.table->fq_ctx);
     stream << "(" << coeff_str << ")*X^" << ix;
     flint_free(coeff_str);
     if (ix != 0) stream << " + ";
@@ -65,6 +74,8 @@ operator<<(
 
   stream << "  /  " << "F_" << curve.table->prime_power;
 
+  fq_nmod_clear(a, curve.table->fq_ctx);
+
   return stream;
 }
 
@@ -73,7 +84,11 @@ Curve(
     shared_ptr<FqElementTable> table,
     const vector<unsigned int> poly_coeff_exponents
     ) :
-    table( table )
+    table( table ),
+    _enumeration( CurveEnumerationCurveIterator ),
+    _orbit_size( 1 ),
+    _normalization( CurveIteratorNormalizationAffine ),
+    _galois_multiplicity( 1 )
 {
   this->poly_coeff_exponents = move(poly_coeff_exponents);
 
@@ -81,6 +96,20 @@ Curve(
     this->poly_coeff_exponents.pop_back();
 }
 
+Curve::
+Curve(
+    shared_ptr<FqElementTable> table,
+    const vector<unsigned int> poly_coeff_exponents,
+    const vector<unsigned int> & ramification_type,
+    unsigned int orbit_size
+    ) :
+    Curve( table, poly_coeff_exponents )
+{
+  this->known_ramification_type = ramification_type;
+  this->_enumeration = CurveEnumerationFactorizationPattern;
+  this->_orbit_size = orbit_size;
+}
+
 unsigned int
 Curve::
 genus()
@@ -162,7 +191,9 @@ convert_poly_coeff_exponents(
 void
 Curve::
 count(
-    ReductionTable & reduction_table
+    ReductionTable & reduction_table,
+    unsigned int nmb_threads,
+    const CurveChunkRunner & run_chunks
   )
 {
   // todo: Use error checking for all calls. Some implementations don't seem to support try/catch, but doublecheck this.
@@ -185,26 +216,155 @@ count(
   // ponts x != 0, infty
   if ( reduction_table.is_opencl_enabled() )
     this->count_opencl(reduction_table, poly_coeff_exponents);
+  else if ( reduction_table.count_variant() == CountVariantBitsliced )
+    this->count_bitsliced(reduction_table, poly_coeff_exponents);
+  else if ( reduction_table.count_variant() == CountVariantPrimeField )
+    this->count_residues();
+  else if ( reduction_table.small_field_kernel )
+    // kernels for small fields evaluate at all x, which is cheaper than
+    // passing to Frobenius orbits
+    this->count_small_field(reduction_table, poly_coeff_exponents);
+  else if ( prime_exponent != this->prime_exponent()
+            && this->has_counted_proper_subfields(prime_exponent) ) {
+    // only x that generate the field over the base field are evaluated,
+    // one for each Frobenius orbit
+    this->count_cpu( reduction_table, poly_coeff_exponents,
+                     reduction_table.frobenius_orbit_representatives(this->prime_exponent()),
+                     nmb_threads, run_chunks );
+    this->count_proper_subfields(prime_exponent);
+  }
   else
-    this->count_cpu(reduction_table, poly_coeff_exponents);
+    this->count_cpu( reduction_table, poly_coeff_exponents, shared_ptr<vector<int32_t>>(),
+                     nmb_threads, run_chunks );
 
+  this->count_zero_and_infinity(prime_exponent);
+}
+
+unsigned int
+Curve::
+max_nmb_chunks(
+    const ReductionTable & reduction_table
+    )
+{
+  return max(1u, reduction_table.prime_power_pred / 2 / Curve::min_chunk_size);
+}
+
+bool
+Curve::
+has_counted_proper_subfields(
+    unsigned int prime_exponent
+    ) const
+{
+  unsigned int relative_exponent = prime_exponent / this->prime_exponent();
+  for ( unsigned int dx = 1; dx < relative_exponent; ++dx )
+    if ( relative_exponent % dx == 0 && !this->has_counted(dx * this->prime_exponent()) )
+      return false;
+  return true;
+}
+
+tuple<unsigned int,unsigned int>
+Curve::
+nmb_points_zero_and_infinity(
+    unsigned int prime_exponent
+    ) const
+{
+  // The exponent c of a coefficient over the base field becomes c (Q-1)/(q-1) over F_Q.
+  // Since (Q-1)/(q-1) = 1 + q + ... + q^(r-1), its parity is the one of r = log_q Q.
+  bool is_even_extension = !((prime_exponent / this->prime_exponent()) & 1);
+  unsigned int zero_index = this->table->zero_index();
+
+  tuple<unsigned int,unsigned int> nmb_points_zero_infinity = make_tuple(0,0);
 
   // point x = 0
   // if constant coefficient is zero
-  if (poly_coeff_exponents.front() == reduction_table.prime_power_pred)
-    get<1>(this->nmb_points[prime_exponent]) += 1;
+  if ( this->poly_coeff_exponents.front() == zero_index )
+    get<1>(nmb_points_zero_infinity) += 1;
   // if constant coefficient is even power of generator
-  else if (!(poly_coeff_exponents.front() & 1))
-    get<0>(this->nmb_points[prime_exponent]) += 2;
+  else if ( is_even_extension || !(this->poly_coeff_exponents.front() & 1) )
+    get<0>(nmb_points_zero_infinity) += 2;
 
 
   // point x = infty
   // if poly_coeffs ends with zero entry
   if ( this->degree() < 2*this->genus() + 2 )
-    get<1>(this->nmb_points[prime_exponent]) += 1;
+    get<1>(nmb_points_zero_infinity) += 1;
   // if leading coefficient is even power of generator
-  else if (!(poly_coeff_exponents.back() & 1))
-    get<0>(this->nmb_points[prime_exponent]) += 2;
+  else if ( is_even_extension || !(this->poly_coeff_exponents.back() & 1) )
+    get<0>(nmb_points_zero_infinity) += 2;
+
+  return nmb_points_zero_infinity;
+}
+
+tuple<unsigned int,unsigned int>
+Curve::
+nmb_points_proper_subfields(
+    unsigned int prime_exponent
+    ) const
+{
+  // By inclusion and exclusion over the maximal subfields, the points with
+  // x != 0, infty and x in a proper subfield of F_{q^r} are
+  //   sum_{1 < m | r squarefree} - mu(m) N'(r/m),
+  // where N'(d) is the number of such points with x in F_{q^d}. Since the
+  // quadratic character of F_{q^r} restricts to the one of F_{q^d} raised to
+  // the r/d-th power, N'(d) can be read off from the number of points over
+  // F_{q^d}: if r/d is even, all nonzero values f(x) are squares.
+
+  unsigned int relative_exponent = prime_exponent / this->prime_exponent();
+
+  vector<unsigned int> prime_factors;
+  for ( unsigned int rx = relative_exponent, px = 2; rx > 1; ++px )
+    if ( rx % px == 0 ) {
+      prime_factors.push_back(px);
+      while ( rx % px == 0 ) rx /= px;
+    }
+
+  int nmb_unramified = 0;
+  int nmb_ramified = 0;
+  for ( unsigned int sx = 1; sx < (1u << prime_factors.size()); ++sx ) {
+    unsigned int subfield_exponent = relative_exponent;
+    int sign = -1;
+    for ( size_t px = 0; px < prime_factors.size(); ++px )
+      if ( sx & (1u << px) ) {
+        subfield_exponent /= prime_factors[px];
+        sign = -sign;
+      }
+    subfield_exponent *= this->prime_exponent();
+
+    auto nmb_points_subfield = this->nmb_points.at(subfield_exponent);
+    auto nmb_points_zero_infinity = this->nmb_points_zero_and_infinity(subfield_exponent);
+    int nmb_unramified_subfield = (int)get<0>(nmb_points_subfield) - (int)get<0>(nmb_points_zero_infinity);
+    int nmb_ramified_subfield = (int)get<1>(nmb_points_subfield) - (int)get<1>(nmb_points_zero_infinity);
+
+    if ( !((prime_exponent / subfield_exponent) & 1) )
+      nmb_unramified_subfield = 2 * ((int)pow(this->prime(), subfield_exponent) - 1 - nmb_ramified_subfield);
+
+    nmb_unramified += sign * nmb_unramified_subfield;
+    nmb_ramified += sign * nmb_ramified_subfield;
+  }
+
+  return make_tuple(nmb_unramified, nmb_ramified);
+}
+
+void
+Curve::
+count_proper_subfields(
+    unsigned int prime_exponent
+    )
+{
+  auto nmb_points_subfields = this->nmb_points_proper_subfields(prime_exponent);
+  get<0>(this->nmb_points[prime_exponent]) += get<0>(nmb_points_subfields);
+  get<1>(this->nmb_points[prime_exponent]) += get<1>(nmb_points_subfields);
+}
+
+void
+Curve::
+count_zero_and_infinity(
+    unsigned int prime_exponent
+    )
+{
+  auto nmb_points_zero_infinity = this->nmb_points_zero_and_infinity(prime_exponent);
+  get<0>(this->nmb_points[prime_exponent]) += get<0>(nmb_points_zero_infinity);
+  get<1>(this->nmb_points[prime_exponent]) += get<1>(nmb_points_zero_infinity);
 }
 
 void
@@ -244,12 +404,105 @@ count_opencl(
 
 void
 Curve::
-count_cpu(
+count_bitsliced(
     const ReductionTable & reduction_table,
     const vector<unsigned int> & poly_coeff_exponents
     )
+{
+  auto nmb_points = reduction_table.bitsliced_evaluation->count(poly_coeff_exponents);
+  get<0>(this->nmb_points[reduction_table.prime_exponent]) += get<0>(nmb_points);
+  get<1>(this->nmb_points[reduction_table.prime_exponent]) += get<1>(nmb_points);
+}
+
+void
+Curve::
+count_small_field(
+    const ReductionTable & reduction_table,
+    const vector<unsigned int> & poly_coeff_exponents
+    )
+{
+  unsigned int nmb_unramified = 0;
+  unsigned int nmb_ramified = 0;
+  reduction_table.small_field_kernel(poly_coeff_exponents, nmb_unramified, nmb_ramified);
+
+  get<0>(this->nmb_points[reduction_table.prime_exponent]) += nmb_unramified;
+  get<1>(this->nmb_points[reduction_table.prime_exponent]) += nmb_ramified;
+}
+
+void
+Curve::
+count_cpu(
+    const ReductionTable & reduction_table,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const shared_ptr<vector<int32_t>> orbit_representatives,
+    unsigned int nmb_threads,
+    const CurveChunkRunner & run_chunks
+    )
 {
   unsigned int prime_exponent = reduction_table.prime_exponent;
+
+  unsigned int nmb_unramified = 0;
+  unsigned int nmb_ramified = 0;
+
+  // either orbit representatives or pairs x, -x
+  unsigned int nmb_xs = orbit_representatives ? orbit_representatives->size()
+                                              : reduction_table.prime_power_pred / 2;
+
+  // chunks that are too small do not pay for starting a thread
+  nmb_threads = min(nmb_threads, nmb_xs / Curve::min_chunk_size);
+  if ( nmb_threads <= 1 )
+    tie(nmb_unramified, nmb_ramified) =
+      this->count_cpu_range(reduction_table, poly_coeff_exponents, orbit_representatives, 0, nmb_xs);
+  else {
+    vector<tuple<unsigned int,unsigned int>> nmbs_points(nmb_threads);
+    vector<function<void()>> chunks;
+    chunks.reserve(nmb_threads);
+    for ( unsigned int tx = 0; tx < nmb_threads; ++tx )
+      chunks.emplace_back( [&, tx]() {
+          nmbs_points[tx] =
+            this->count_cpu_range( reduction_table, poly_coeff_exponents, orbit_representatives,
+                                   (size_t)nmb_xs * tx / nmb_threads,
+                                   (size_t)nmb_xs * (tx+1) / nmb_threads );
+        } );
+
+    if ( run_chunks )
+      run_chunks(chunks);
+    else {
+      vector<thread> threads;
+      threads.reserve(nmb_threads - 1);
+      for ( unsigned int tx = 1; tx < nmb_threads; ++tx )
+        threads.emplace_back(chunks[tx]);
+      chunks.front()();
+      for ( auto & worker : threads )
+        worker.join();
+    }
+    for ( const auto & chunk_points : nmbs_points ) {
+      nmb_unramified += get<0>(chunk_points);
+      nmb_ramified += get<1>(chunk_points);
+    }
+  }
+
+  if ( orbit_representatives ) {
+    // each x stands for its Frobenius orbit
+    unsigned int weight = prime_exponent / this->prime_exponent();
+    nmb_unramified *= weight;
+    nmb_ramified *= weight;
+  }
+
+  get<0>(this->nmb_points[prime_exponent]) += nmb_unramified;
+  get<1>(this->nmb_points[prime_exponent]) += nmb_ramified;
+}
+
+tuple<unsigned int,unsigned int>
+Curve::
+count_cpu_range(
+    const ReductionTable & reduction_table,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const shared_ptr<vector<int32_t>> orbit_representatives,
+    unsigned int begin,
+    unsigned int end
+    ) const
+{
   unsigned int prime_power_pred = reduction_table.prime_power_pred;
 
   const auto & exponent_reduction_table = *reduction_table.exponent_reduction_table;
@@ -257,41 +510,166 @@ count_cpu(
 
   unsigned int poly_size = poly_coeff_exponents.size();
 
+  unsigned int nmb_unramified = 0;
+  unsigned int nmb_ramified = 0;
+
+
+  EvaluationSIMD simd =
+    reduction_table.count_variant() == CountVariantScalarTables ? EvaluationSIMDScalar : evaluation_simd();
+  // specialized kernels need the compact tables
+  const CompactZechEntry * zech_table =
+    reduction_table.compact_zech_table ? reduction_table.compact_zech_table->data() : nullptr;
+  unsigned int support = count_kernel_support(poly_coeff_exponents, prime_power_pred);
+
+  if ( orbit_representatives ) {
+    unsigned int ix_begin =
+      evaluate_simd( simd, poly_coeff_exponents, prime_power_pred,
+                     exponent_reduction_table, incrementation_table,
+                     *orbit_representatives, begin, end, nmb_unramified, nmb_ramified );
+
+    auto kernel = zech_table ? count_xs_kernel(poly_size, support) : nullptr;
+    if ( kernel ) {
+      kernel( poly_coeff_exponents.data(), prime_power_pred, zech_table,
+              orbit_representatives->data(), ix_begin, end,
+              nmb_unramified, nmb_ramified );
+      ix_begin = end;
+    }
 
-  for ( unsigned int x = 1; x <= prime_power_pred; ++x ) {
-    unsigned int f = poly_coeff_exponents[0];
-    for ( unsigned int dx=1, xpw=x; dx < poly_size; ++dx, xpw+=x ) {
-      xpw = exponent_reduction_table[xpw];
-      if ( poly_coeff_exponents[dx] != prime_power_pred ) { // i.e. coefficient is not zero
-        if ( f == prime_power_pred ) { // i.e. f = 0
-          f = poly_coeff_exponents[dx] + xpw;
-          f = exponent_reduction_table[f];
-        } else {
-          unsigned int tmp = exponent_reduction_table[poly_coeff_exponents[dx] + xpw];
-
-          unsigned int tmp2;
-          if (tmp <= f) {
-            // todo: this can be removed by doubling the size of incrementation_table
-            // and checking at prime_power_pred + 1 + tmp - f
-            tmp2 = f;
-            f = tmp;
-            tmp = tmp2;
-          }
-          tmp2 = incrementation_table[tmp-f];
-          if ( tmp2 != prime_power_pred ) {
-            f = f + tmp2;
-            f = exponent_reduction_table[f];
-          } else
-            f = prime_power_pred;
+    for ( unsigned int ix = ix_begin; ix < end; ++ix ) {
+      unsigned int x = (*orbit_representatives)[ix];
+      unsigned int f = poly_coeff_exponents[0];
+      for ( unsigned int dx=1, xpw=x; dx < poly_size; ++dx, xpw+=x ) {
+        xpw = exponent_reduction_table[xpw];
+        if ( poly_coeff_exponents[dx] != prime_power_pred ) // i.e. coefficient is not zero
+          f = add_exponents( f, exponent_reduction_table[poly_coeff_exponents[dx] + xpw],
+                             prime_power_pred, exponent_reduction_table, incrementation_table );
+      }
+
+      if ( f == prime_power_pred )
+        nmb_ramified += 1;
+      else if ( !(f & 1) )
+        nmb_unramified += 2;
+    }
+  }
+  else {
+    // We treat x and -x = a^(i + (q-1)/2) together. If f = E + O is the
+    // decomposition into even and odd part, then f(-x) = E(x) - O(x).
+    unsigned int minus_one_exponent = prime_power_pred / 2;
+
+    unsigned int x_begin =
+      evaluate_even_odd_simd( simd, poly_coeff_exponents, prime_power_pred,
+                              exponent_reduction_table, incrementation_table,
+                              begin, end, nmb_unramified, nmb_ramified );
+
+    auto kernel = zech_table ? count_even_odd_kernel(poly_size, support) : nullptr;
+    if ( kernel ) {
+      kernel( poly_coeff_exponents.data(), prime_power_pred, zech_table,
+              x_begin, end, nmb_unramified, nmb_ramified );
+      x_begin = end;
+    }
+
+    for ( unsigned int x = x_begin; x < end; ++x ) {
+      unsigned int f_even = poly_coeff_exponents[0];
+      unsigned int f_odd = prime_power_pred;
+      for ( unsigned int dx=1, xpw=x; dx < poly_size; ++dx, xpw+=x ) {
+        xpw = exponent_reduction_table[xpw];
+        if ( poly_coeff_exponents[dx] != prime_power_pred ) { // i.e. coefficient is not zero
+          unsigned int term = exponent_reduction_table[poly_coeff_exponents[dx] + xpw];
+          if ( dx & 1 )
+            f_odd = add_exponents( f_odd, term,
+                                   prime_power_pred, exponent_reduction_table, incrementation_table );
+          else
+            f_even = add_exponents( f_even, term,
+                                    prime_power_pred, exponent_reduction_table, incrementation_table );
         }
       }
+
+      unsigned int f = add_exponents( f_even, f_odd,
+                                      prime_power_pred, exponent_reduction_table, incrementation_table );
+      if ( f == prime_power_pred )
+        nmb_ramified += 1;
+      else if ( !(f & 1) )
+        nmb_unramified += 2;
+
+      if ( f_odd != prime_power_pred )
+        f = add_exponents( f_even, exponent_reduction_table[f_odd + minus_one_exponent],
+                           prime_power_pred, exponent_reduction_table, incrementation_table );
+      else
+        f = f_even;
+      if ( f == prime_power_pred )
+        nmb_ramified += 1;
+      else if ( !(f & 1) )
+        nmb_unramified += 2;
     }
+  }
+
+  return make_tuple(nmb_unramified, nmb_ramified);
+}
 
-    if ( f == prime_power_pred )
-      get<1>(this->nmb_points[prime_exponent]) += 1;
-    else if ( !(f & 1) )
-      get<0>(this->nmb_points[prime_exponent]) += 2;
+void
+Curve::
+count_prime_field()
+{
+  if ( !this->table->is_prime_field() ) {
+    cerr << "Curve.count_prime_field: curve must be defined over a prime field" << endl;
+    throw;
   }
+  unsigned int prime = this->prime();
+  if ( prime >= (1u << 16) ) {
+    cerr << "Curve.count_prime_field: prime must be less than 2^16: " << prime << endl;
+    throw;
+  }
+
+  if ( this->nmb_points.find(1) != this->nmb_points.end() )
+    return;
+  this->nmb_points[1] = make_tuple(0,0);
+
+  this->count_residues();
+  this->count_zero_and_infinity(1);
+}
+
+void
+Curve::
+count_residues()
+{
+  unsigned int prime = this->prime();
+
+  // Horner's scheme modulo p with Barrett reduction: for t < 2^32 and
+  // m = floor(2^32 / p), the remainder t - floor(t m / 2^32) p is less than 2p.
+  uint32_t barrett_multiplier = (1ull << 32) / prime;
+  auto reduce = [prime, barrett_multiplier] (uint32_t t)
+    {
+      uint32_t r = t - (uint32_t)(((uint64_t)t * barrett_multiplier) >> 32) * prime;
+      return r >= prime ? r - prime : r;
+    };
+
+  vector<unsigned int> poly_coeffs;
+  for ( auto c : this->poly_coeff_exponents )
+    poly_coeffs.push_back(c == this->table->zero_index() ? 0 : this->table->at_nmod(c));
+
+  // the bitmap of nonzero squares is shared by all curves over the table
+  const vector<uint32_t> & quadratic_residues = this->table->quadratic_residues;
+
+  unsigned int nmb_unramified = 0;
+  unsigned int nmb_ramified = 0;
+
+  unsigned int x_begin =
+    evaluate_prime_field_simd( evaluation_simd(), poly_coeffs, prime, quadratic_residues,
+                               nmb_unramified, nmb_ramified );
+
+  for ( unsigned int x = x_begin; x < prime; ++x ) {
+    uint32_t f = poly_coeffs.back();
+    for ( size_t dx = poly_coeffs.size() - 1; dx-- > 0; )
+      f = reduce(f * x + poly_coeffs[dx]);
+
+    if ( f == 0 )
+      nmb_ramified += 1;
+    else if ( quadratic_residues[f / 32] & (1u << (f % 32)) )
+      nmb_unramified += 2;
+  }
+
+  get<0>(this->nmb_points[1]) += nmb_unramified;
+  get<1>(this->nmb_points[1]) += nmb_ramified;
 }
 
 void
@@ -618,6 +996,9 @@ Curve::
 ramification_type()
   const
 {
+  if ( this->has_known_ramification_type() )
+    return this->known_ramification_type;
+
   vector<unsigned int> ramifications;
 
   // try to compute ramification from point counts
@@ -654,43 +1035,100 @@ ramification_type()
 
 
   // if ramification can not be computed from available point count,
-  // factor the right hand side polynomial
+  // find the degrees of the factors of the right hand side polynomial
 
-  ramifications.clear();
+  ramifications = this->rhs_factor_degrees();
   if ( this->degree() % 2 == 1 )
     ramifications.push_back(1);
+
+  sort(ramifications.begin(), ramifications.end());
+  return ramifications;
+}
+
+vector<unsigned int>
+Curve::
+rhs_factor_degrees()
+  const
+{
+  // Distinct-degree factorization: Once all factors of degree less than k
+  // are removed, the gcd with x^(q^k) - x is the product of all factors of
+  // degree k. The powers x^(q^k) are obtained one from the other by raising
+  // to the q-th power modulo the remaining polynomial, which stays reduced
+  // after removing factors. This requires the right hand side to be squarefree.
+  vector<unsigned int> degrees;
+
   if ( this->table->is_prime_field() ) {
     auto poly = this->rhs_nmod_polynomial();
-    nmod_poly_factor_t poly_factor;
-    nmod_poly_factor_init(poly_factor);
-    nmod_poly_factor(poly_factor, &poly);
-
-    for (unsigned int ix=0; ix<(unsigned int)poly_factor->num; ++ix)
-      for (unsigned int jx=0; jx<(unsigned int)poly_factor->exp[ix]; ++jx)
-        ramifications.push_back(nmod_poly_degree(poly_factor->p + ix));
+    nmod_poly_make_monic(&poly, &poly);
+
+    nmod_poly_t x, xpw, factor;
+    nmod_poly_init(x, this->table->prime);
+    nmod_poly_init(xpw, this->table->prime);
+    nmod_poly_init(factor, this->table->prime);
+    nmod_poly_set_coeff_ui(x, 1, 1);
+    nmod_poly_set(xpw, x);
+
+    for ( unsigned int kx = 1; 2*kx <= (unsigned int)nmod_poly_degree(&poly); ++kx ) {
+      nmod_poly_powmod_ui_binexp(xpw, xpw, this->table->prime_power, &poly);
+      nmod_poly_sub(factor, xpw, x);
+      nmod_poly_gcd(factor, &poly, factor);
+
+      unsigned int factor_degree = nmod_poly_degree(factor);
+      if ( factor_degree == 0 )
+        continue;
+      for ( unsigned int dx = 0; dx < factor_degree; dx += kx )
+        degrees.push_back(kx);
+      nmod_poly_div(&poly, &poly, factor);
+      nmod_poly_rem(xpw, xpw, &poly);
+    }
+    // what remains is irreducible
+    if ( nmod_poly_degree(&poly) > 0 )
+      degrees.push_back(nmod_poly_degree(&poly));
 
-    nmod_poly_factor_clear(poly_factor);
+    nmod_poly_clear(factor);
+    nmod_poly_clear(xpw);
+    nmod_poly_clear(x);
     nmod_poly_clear(&poly);
   }
   else {
-    auto poly = this->rhs_polynomial();
-    fq_nmod_t lead;
-    fq_nmod_init(lead, this->table->fq_ctx);
-    fq_nmod_poly_factor_t poly_factor;
-    fq_nmod_poly_factor_init(poly_factor, this->table->fq_ctx);
-    fq_nmod_poly_factor(poly_factor, lead, &poly, this->table->fq_ctx);
-
-    for (unsigned int ix=0; ix<(unsigned int)poly_factor->num; ++ix)
-      for (unsigned int jx=0; jx<(unsigned int)poly_factor->exp[ix]; ++jx)
-        ramifications.push_back(fq_nmod_poly_degree(poly_factor->poly + ix, this->table->fq_ctx));
+    const auto & fq_ctx = this->table->fq_ctx;
 
-    fq_nmod_poly_factor_clear(poly_factor, this->table->fq_ctx);
-    fq_nmod_poly_clear(&poly, this->table->fq_ctx);
-    fq_nmod_clear(lead, this->table->fq_ctx);
+    auto poly = this->rhs_polynomial();
+    fq_nmod_poly_make_monic(&poly, &poly, fq_ctx);
+
+    fq_nmod_poly_t x, xpw, factor, remainder;
+    fq_nmod_poly_init(x, fq_ctx);
+    fq_nmod_poly_init(xpw, fq_ctx);
+    fq_nmod_poly_init(factor, fq_ctx);
+    fq_nmod_poly_init(remainder, fq_ctx);
+    fq_nmod_poly_gen(x, fq_ctx);
+    fq_nmod_poly_set(xpw, x, fq_ctx);
+
+    for ( unsigned int kx = 1; 2*kx <= (unsigned int)fq_nmod_poly_degree(&poly, fq_ctx); ++kx ) {
+      fq_nmod_poly_powmod_ui_binexp(xpw, xpw, this->table->prime_power, &poly, fq_ctx);
+      fq_nmod_poly_sub(factor, xpw, x, fq_ctx);
+      fq_nmod_poly_gcd(factor, &poly, factor, fq_ctx);
+
+      unsigned int factor_degree = fq_nmod_poly_degree(factor, fq_ctx);
+      if ( factor_degree == 0 )
+        continue;
+      for ( unsigned int dx = 0; dx < factor_degree; dx += kx )
+        degrees.push_back(kx);
+      fq_nmod_poly_divrem(&poly, remainder, &poly, factor, fq_ctx);
+      fq_nmod_poly_rem(xpw, xpw, &poly, fq_ctx);
+    }
+    // what remains is irreducible
+    if ( fq_nmod_poly_degree(&poly, fq_ctx) > 0 )
+      degrees.push_back(fq_nmod_poly_degree(&poly, fq_ctx));
+
+    fq_nmod_poly_clear(remainder, fq_ctx);
+    fq_nmod_poly_clear(factor, fq_ctx);
+    fq_nmod_poly_clear(xpw, fq_ctx);
+    fq_nmod_poly_clear(x, fq_ctx);
+    fq_nmod_poly_clear(&poly, fq_ctx);
   }
 
-  sort(ramifications.begin(), ramifications.end());
-  return ramifications;
+  return degrees;
 }
 
 nmod_poly_struct
@@ -720,8 +1158,13 @@ rhs_polynomial()
   fq_nmod_poly_struct poly;
   fq_nmod_poly_init2( &poly, this->poly_coeff_exponents.size(), this->table->fq_ctx );
 
-  for (long int ix=0; ix<(long int)this->poly_coeff_exponents.size(); ++ix)
-    fq_nmod_poly_set_coeff( &poly, ix, this->table->at(this->poly_coeff_exponents[ix]), this->table->fq_ctx );
+  fq_nmod_t a;
+  fq_nmod_init(a, this->table->fq_ctx);
+  for (long int ix=0; ix<(long int)this->poly_coeff_exponents.size(); ++ix) {
+    this->table->element(a, this->poly_coeff_exponents[ix]);
+    fq_nmod_poly_set_coeff( &poly, ix, a, this->table->fq_ctx );
+  }
+  fq_nmod_clear(a, this->table->fq_ctx);
 
   return poly;
 }
@@ -24,6 +24,7 @@
 #ifndef _H_CURVE
 #define _H_CURVE
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <vector>
@@ -37,16 +38,34 @@
 #include "reduction_table.hh"
 
 
+using std::function;
 using std::map;
 using std::shared_ptr;
 using std::vector;
 using std::tuple;
 
 
+// the enumeration that a curve stems from, which determines its weight
+enum CurveEnumeration
+{
+  CurveEnumerationCurveIterator,
+  CurveEnumerationFactorizationPattern
+};
+
+// runs all chunks of a curve evaluation and returns once they are finished;
+// the first chunk is meant to run on the calling thread
+typedef function<void(const vector<function<void()>> & chunks)> CurveChunkRunner;
+
+
 class Curve
 {
   public:
     Curve(shared_ptr<FqElementTable> table, const vector<unsigned int> poly_coeff_exponents);
+    // a curve enumerated by FactorizationPatternIterator, whose ramification
+    // type is known from its construction, and which stands for an orbit of
+    // the given size
+    Curve( shared_ptr<FqElementTable> table, const vector<unsigned int> poly_coeff_exponents,
+           const vector<unsigned int> & ramification_type, unsigned int orbit_size );
 
     unsigned int inline prime() const { return this->table->prime; };
     unsigned int inline prime_exponent() const { return this->table->prime_exponent; };
@@ -63,15 +82,25 @@ class Curve
 
     vector<unsigned int> convert_poly_coeff_exponents(const ReductionTable & table);
 
-    void count(ReductionTable & table);
-    void inline count(const shared_ptr<ReductionTable> table)
+    // with several threads, the x are split into chunks that are evaluated in
+    // parallel by the given runner, or by threads of their own without one
+    void count( ReductionTable & table, unsigned int nmb_threads = 1,
+                const CurveChunkRunner & run_chunks = CurveChunkRunner() );
+    void inline count( const shared_ptr<ReductionTable> table, unsigned int nmb_threads = 1,
+                       const CurveChunkRunner & run_chunks = CurveChunkRunner() )
     {
-      this->count(*table);
+      this->count(*table, nmb_threads, run_chunks);
     };
+    // the largest number of chunks into which count splits the x of a curve
+    // over the given table
+    static unsigned int max_nmb_chunks(const ReductionTable & table);
+    // count over the prime field with residues instead of exponents
+    void count_prime_field();
     void count_naive_nmod(unsigned int prime_exponent);
     void count_naive_zech(unsigned int prime_exponent);
 
     bool has_counted(size_t fx) const { return (this->nmb_points.find(fx) != this->nmb_points.end()); };
+    bool has_counted_proper_subfields(unsigned int prime_exponent) const;
 
     const map<unsigned int, tuple<unsigned int,unsigned int>> & number_of_points() const { return this->nmb_points; };
     vector<tuple<unsigned int,unsigned int>> number_of_points(unsigned int max_prime_exponent) const;
@@ -81,8 +110,20 @@ class Curve
     vector<int> hasse_weil_offsets(unsigned int max_prime_exponent) const;
 
     vector<unsigned int> ramification_type() const;
+    bool inline has_known_ramification_type() const { return !this->known_ramification_type.empty(); };
+    inline CurveEnumeration enumeration() const { return this->_enumeration; };
+    // the number of right hand sides in the orbit under FactorizationPatternIterator
+    inline unsigned int orbit_size() const { return this->_orbit_size; };
+    // the normalization of the enumeration that the curve stems from
+    inline CurveIteratorNormalization normalization() const { return this->_normalization; };
+    // the number of Frobenius conjugates that the curve stands for
+    inline unsigned int galois_multiplicity() const { return this->_galois_multiplicity; };
+
+    // degrees of the irreducible factors of the squarefree right hand side
+    vector<unsigned int> rhs_factor_degrees() const;
 
     friend ostream& operator<<(ostream &stream, const Curve & curve);
+    friend class CurveBlock;
 
   protected:
     const shared_ptr<FqElementTable> table;
@@ -90,9 +131,36 @@ class Curve
 
     map<unsigned int, tuple<unsigned int,unsigned int>> nmb_points;
 
+    vector<unsigned int> known_ramification_type;
+    CurveEnumeration _enumeration;
+    unsigned int _orbit_size;
+
+    CurveIteratorNormalization _normalization;
+    unsigned int _galois_multiplicity;
+
   private:
+    tuple<unsigned int,unsigned int> nmb_points_zero_and_infinity(unsigned int prime_exponent) const;
+    tuple<unsigned int,unsigned int> nmb_points_proper_subfields(unsigned int prime_exponent) const;
+
+    void count_zero_and_infinity(unsigned int prime_exponent);
+    void count_proper_subfields(unsigned int prime_exponent);
     void count_opencl(ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents);
-    void count_cpu(const ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents);
+    void count_bitsliced(const ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents);
+    void count_residues();
+    void count_small_field(const ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents);
+    void count_cpu( const ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents,
+                    const shared_ptr<vector<int32_t>> orbit_representatives = shared_ptr<vector<int32_t>>(),
+                    unsigned int nmb_threads = 1,
+                    const CurveChunkRunner & run_chunks = CurveChunkRunner() );
+    // numbers of points for the orbit representatives with index in [begin, end)
+    // or, without them, for x = a^i and -x with i in [begin, end)
+    tuple<unsigned int,unsigned int>
+        count_cpu_range( const ReductionTable & table, const vector<unsigned int> & poly_coeff_exponents,
+                         const shared_ptr<vector<int32_t>> orbit_representatives,
+                         unsigned int begin, unsigned int end ) const;
+
+    // the least number of x that is given to a thread by count_cpu
+    static const unsigned int min_chunk_size;
 };
 
 #endif
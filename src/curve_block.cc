@@ -0,0 +1,875 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#include <algorithm>
+#include <cstdint>
+#include <flint/fq_nmod_poly.h>
+#include <flint/nmod_poly.h>
+#include <flint/ulong_extras.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "count_kernels.hh"
+#include "curve_block.hh"
+#include "evaluation_simd.hh"
+
+
+using namespace std;
+
+
+const unsigned int CurveBlock::tile_size = 1024;
+
+
+CurveBlock::
+CurveBlock(
+    shared_ptr<FqElementTable> table,
+    const vuu_block & block,
+    CurveBlockCountImplementation implementation,
+    shared_ptr<CurveBlockPrefixCache> prefix_cache,
+    CurveIteratorNormalization normalization,
+    shared_ptr<const CurveIterator> galois_reduction
+    ) :
+  table( table ),
+  block( block ),
+  implementation( implementation ),
+  prefix_cache( prefix_cache )
+{
+  // We enumerate the block by a reflected mixed radix Gray code, so that
+  // consecutive positions differ in exactly one coefficient exponent.
+  vector<size_t> varying_ixs;
+  vector<unsigned int> position;
+  position.reserve(block.size());
+  for ( size_t ix = 0; ix < block.size(); ++ix ) {
+    unsigned int lbd, ubd;
+    tie(lbd,ubd) = block[ix];
+    if ( lbd >= ubd ) {
+      cerr << "CurveBlock: block lower and upper bound must differ by at least 1" << endl;
+      throw;
+    }
+
+    position.push_back(lbd);
+    if ( ubd - lbd > 1 )
+      varying_ixs.push_back(ix);
+  }
+  this->gray_initial_position = position;
+
+  this->prefix_position = vector<unsigned int>(block.size(), this->table->zero_index());
+  for ( size_t ix = 1; ix < block.size(); ++ix )
+    if ( get<1>(block[ix]) - get<0>(block[ix]) == 1 )
+      this->prefix_position[ix] = get<0>(block[ix]);
+    else
+      this->tail_ixs.push_back(ix);
+
+  // Whether f + c is squarefree is decided for all constants c at once,
+  // whenever the non-constant part f changes.
+  vector<bool> is_non_squarefree_constant;
+  bool has_non_squarefree_constants = false;
+  bool non_constant_part_changed = true;
+
+  // Under projective normalization, curves of even degree with a rational
+  // ramification point are represented by curves of odd degree.
+  bool omits_rational_roots =
+       normalization == CurveIteratorNormalizationProjective
+    && (block.size() - 1) % 2 == 0;
+  vector<bool> is_rational_root_constant;
+
+  vector<bool> ascending(varying_ixs.size(), true);
+  while ( true ) {
+    if ( non_constant_part_changed ) {
+      has_non_squarefree_constants =
+        this->non_squarefree_constants(position, is_non_squarefree_constant);
+      if ( omits_rational_roots )
+        this->rational_root_constants(position, is_rational_root_constant);
+      non_constant_part_changed = false;
+    }
+
+    unsigned int galois_mult = 1;
+    if ( galois_reduction )
+      galois_mult = galois_reduction->galois_multiplicity(position);
+
+    bool is_curve;
+    if ( galois_mult == 0 )
+      is_curve = false;
+    else if ( omits_rational_roots && is_rational_root_constant[position[0]] )
+      is_curve = false;
+    else if ( has_non_squarefree_constants )
+      is_curve = !is_non_squarefree_constant[position[0]];
+    else
+      is_curve = Curve(this->table, position).has_squarefree_rhs();
+    this->gray_is_curve.push_back(is_curve);
+    if ( is_curve ) {
+      this->curves.emplace_back(this->table, position);
+      this->curves.back()._normalization = normalization;
+      this->curves.back()._galois_multiplicity = galois_mult;
+    }
+
+    // find the first coefficient that can be moved in its current direction
+    size_t vx;
+    for ( vx = 0; vx < varying_ixs.size(); ++vx ) {
+      unsigned int lbd, ubd;
+      tie(lbd,ubd) = block[varying_ixs[vx]];
+      unsigned int c = position[varying_ixs[vx]];
+      if ( ascending[vx] ? c + 1 < ubd : c > lbd )
+        break;
+    }
+    if ( vx == varying_ixs.size() )
+      break;
+
+    for ( size_t wx = 0; wx < vx; ++wx )
+      ascending[wx] = !ascending[wx];
+
+    size_t ix = varying_ixs[vx];
+    unsigned int c_old = position[ix];
+    position[ix] = ascending[vx] ? c_old + 1 : c_old - 1;
+    this->gray_changes.emplace_back(ix, c_old, position[ix]);
+    non_constant_part_changed = ix != 0;
+  }
+}
+
+bool
+CurveBlock::
+non_squarefree_constants(
+    const vector<unsigned int> & position,
+    vector<bool> & is_non_squarefree
+    ) const
+{
+  // The polynomial f + c has a multiple root b if and only if f'(b) = 0 and
+  // f(b) = -c. For an irreducible factor u of f' with root b, the value f(b)
+  // lies in F_q if and only if f mod u is constant. These constants are the
+  // roots of the discriminant of f + c as a polynomial in c.
+  const auto & fq_ctx = this->table->fq_ctx;
+
+  fq_nmod_t a;
+  fq_nmod_init(a, fq_ctx);
+  fq_nmod_poly_t poly;
+  fq_nmod_poly_init(poly, fq_ctx);
+  for ( size_t ix = 1; ix < position.size(); ++ix ) {
+    this->table->element(a, position[ix]);
+    fq_nmod_poly_set_coeff(poly, ix, a, fq_ctx);
+  }
+  fq_nmod_clear(a, fq_ctx);
+
+  fq_nmod_poly_t derivative;
+  fq_nmod_poly_init(derivative, fq_ctx);
+  fq_nmod_poly_derivative(derivative, poly, fq_ctx);
+
+  // if f' vanishes, the squarefree test is left to the curves
+  if ( fq_nmod_poly_is_zero(derivative, fq_ctx) ) {
+    fq_nmod_poly_clear(derivative, fq_ctx);
+    fq_nmod_poly_clear(poly, fq_ctx);
+    return false;
+  }
+
+  is_non_squarefree.assign(this->table->prime_power, false);
+
+  if ( fq_nmod_poly_degree(derivative, fq_ctx) > 0 ) {
+    fq_nmod_t lead;
+    fq_nmod_init(lead, fq_ctx);
+    fq_nmod_poly_factor_t derivative_factor;
+    fq_nmod_poly_factor_init(derivative_factor, fq_ctx);
+    fq_nmod_poly_factor(derivative_factor, lead, derivative, fq_ctx);
+
+    fq_nmod_poly_t remainder;
+    fq_nmod_poly_init(remainder, fq_ctx);
+    fq_nmod_t c;
+    fq_nmod_init(c, fq_ctx);
+
+    for ( slong ix = 0; ix < derivative_factor->num; ++ix ) {
+      fq_nmod_poly_rem(remainder, poly, derivative_factor->poly + ix, fq_ctx);
+      if ( fq_nmod_poly_degree(remainder, fq_ctx) > 0 )
+        continue;
+
+      fq_nmod_poly_get_coeff(c, remainder, 0, fq_ctx);
+      fq_nmod_neg(c, c, fq_ctx);
+      is_non_squarefree[this->table->index(c)] = true;
+    }
+
+    fq_nmod_clear(c, fq_ctx);
+    fq_nmod_poly_clear(remainder, fq_ctx);
+    fq_nmod_poly_factor_clear(derivative_factor, fq_ctx);
+    fq_nmod_clear(lead, fq_ctx);
+  }
+
+  fq_nmod_poly_clear(derivative, fq_ctx);
+  fq_nmod_poly_clear(poly, fq_ctx);
+  return true;
+}
+
+void
+CurveBlock::
+rational_root_constants(
+    const vector<unsigned int> & position,
+    vector<bool> & has_rational_root
+    ) const
+{
+  // The polynomial f + c has the root x if and only if c = -f(x).
+  const auto & fq_ctx = this->table->fq_ctx;
+
+  fq_nmod_t a;
+  fq_nmod_init(a, fq_ctx);
+  fq_nmod_poly_t poly;
+  fq_nmod_poly_init(poly, fq_ctx);
+  for ( size_t ix = 1; ix < position.size(); ++ix ) {
+    this->table->element(a, position[ix]);
+    fq_nmod_poly_set_coeff(poly, ix, a, fq_ctx);
+  }
+
+  has_rational_root.assign(this->table->prime_power, false);
+
+  fq_nmod_t c;
+  fq_nmod_init(c, fq_ctx);
+  for ( unsigned int xx = 0; xx < this->table->prime_power; ++xx ) {
+    this->table->element(a, xx);
+    fq_nmod_poly_evaluate_fq_nmod(c, poly, a, fq_ctx);
+    fq_nmod_neg(c, c, fq_ctx);
+    has_rational_root[this->table->index(c)] = true;
+  }
+
+  fq_nmod_clear(c, fq_ctx);
+  fq_nmod_clear(a, fq_ctx);
+  fq_nmod_poly_clear(poly, fq_ctx);
+}
+
+void
+CurveBlock::
+count(
+    ReductionTable & reduction_table,
+    unsigned int nmb_threads,
+    const CurveChunkRunner & run_chunks
+    )
+{
+  if ( reduction_table.prime != this->table->prime ) {
+    cerr << "CurveBlock.count: primes of curves and table must coincide: "
+         << reduction_table.prime << " " << this->table->prime << endl;
+    throw;
+  }
+
+  CurveBlockCountImplementation implementation = this->implementation;
+  if ( implementation == CurveBlockCountImplementationTuned )
+    implementation = reduction_table.block_count_implementation();
+
+  // other variants than table lookups evaluate one curve at a time, and so
+  // do counting with several threads, which split the x of each curve, and
+  // the kernels for small fields
+  if (  reduction_table.is_opencl_enabled()
+     || reduction_table.count_variant() == CountVariantBitsliced
+     || reduction_table.count_variant() == CountVariantPrimeField
+     || nmb_threads > 1
+     || (  implementation == CurveBlockCountImplementationSmallField
+        && reduction_table.small_field_kernel ) ) {
+    for ( auto & curve : this->curves )
+      curve.count(reduction_table, nmb_threads, run_chunks);
+    return;
+  }
+
+  unsigned int prime_exponent = reduction_table.prime_exponent;
+
+  vector<size_t> curve_ixs;
+  vector<vector<unsigned int>> poly_coeff_exponents;
+  curve_ixs.reserve(this->curves.size());
+  poly_coeff_exponents.reserve(this->curves.size());
+  for ( size_t cx = 0; cx < this->curves.size(); ++cx ) {
+    auto & curve = this->curves[cx];
+    if ( curve.has_counted(prime_exponent) )
+      continue;
+
+    curve.nmb_points[prime_exponent] = make_tuple(0,0);
+    curve_ixs.push_back(cx);
+    // this also checks that the prime exponent is divisible by the one of the curve
+    poly_coeff_exponents.push_back(curve.convert_poly_coeff_exponents(reduction_table));
+  }
+
+  if ( curve_ixs.empty() )
+    return;
+
+  // if all curves have been counted over proper subfields, it suffices to
+  // evaluate one x for each Frobenius orbit of generators of the field
+  bool has_counted_proper_subfields = prime_exponent != this->table->prime_exponent;
+  for ( size_t cx : curve_ixs )
+    if ( !has_counted_proper_subfields ) break;
+    else has_counted_proper_subfields = this->curves[cx].has_counted_proper_subfields(prime_exponent);
+
+  shared_ptr<vector<int32_t>> orbit_representatives;
+  if ( has_counted_proper_subfields )
+    orbit_representatives = reduction_table.frobenius_orbit_representatives(this->table->prime_exponent);
+
+  // points x != 0, infty
+  if ( implementation == CurveBlockCountImplementationCorrelation
+       && this->table->is_prime_field()
+       && get<1>(this->block[0]) - get<0>(this->block[0]) > 1 )
+    this->count_correlation(reduction_table, curve_ixs, orbit_representatives);
+  else if ( implementation == CurveBlockCountImplementationTiled )
+    this->count_cpu(reduction_table, curve_ixs, poly_coeff_exponents, orbit_representatives);
+  else
+    this->count_gray_code(reduction_table, curve_ixs, orbit_representatives);
+
+  for ( size_t cx : curve_ixs ) {
+    if ( has_counted_proper_subfields )
+      this->curves[cx].count_proper_subfields(prime_exponent);
+    this->curves[cx].count_zero_and_infinity(prime_exponent);
+  }
+}
+
+shared_ptr<const vector<unsigned int>>
+CurveBlockPrefixCache::
+find(
+    unsigned int prime_exponent,
+    const vector<unsigned int> & prefix
+    ) const
+{
+  auto entry_it = this->entries.find(prime_exponent);
+  if ( entry_it == this->entries.end() || get<0>(entry_it->second) != prefix )
+    return shared_ptr<const vector<unsigned int>>();
+  return get<1>(entry_it->second);
+}
+
+void
+CurveBlockPrefixCache::
+insert(
+    unsigned int prime_exponent,
+    const vector<unsigned int> & prefix,
+    shared_ptr<const vector<unsigned int>> values
+    )
+{
+  this->entries[prime_exponent] = make_tuple(prefix, values);
+}
+
+shared_ptr<const vector<unsigned int>>
+CurveBlock::
+prefix_values(
+    const ReductionTable & reduction_table
+    )
+{
+  unsigned int prime_exponent = reduction_table.prime_exponent;
+
+  if ( this->prefix_cache ) {
+    auto values = this->prefix_cache->find(prime_exponent, this->prefix_position);
+    if ( values )
+      return values;
+  }
+
+
+  unsigned int prime_power_pred = reduction_table.prime_power_pred;
+
+  const auto & exponent_reduction_table = *reduction_table.exponent_reduction_table;
+  const auto & incrementation_table = *reduction_table.incrementation_table;
+
+  unsigned int base_prime_power_pred = this->table->prime_power_pred;
+  unsigned int exponent_factor = prime_power_pred / base_prime_power_pred;
+
+  vector<unsigned int> poly;
+  poly.reserve(this->prefix_position.size());
+  for ( unsigned int c : this->prefix_position )
+    poly.push_back(c != base_prime_power_pred ? exponent_factor * c : prime_power_pred);
+
+  auto values = make_shared<vector<unsigned int>>(prime_power_pred);
+  for ( unsigned int j = 0; j < prime_power_pred; ++j ) {
+    unsigned int f = prime_power_pred;
+    for ( unsigned int dx=1, xpw=j; dx < poly.size(); ++dx, xpw+=j ) {
+      xpw = exponent_reduction_table[xpw];
+      if ( poly[dx] != prime_power_pred )
+        f = add_exponents( f, exponent_reduction_table[poly[dx] + xpw],
+                           prime_power_pred, exponent_reduction_table, incrementation_table );
+    }
+    (*values)[j] = f;
+  }
+
+  if ( this->prefix_cache )
+    this->prefix_cache->insert(prime_exponent, this->prefix_position, values);
+  return values;
+}
+
+EvaluateValuesKernel
+CurveBlock::
+values_kernel(
+    const ReductionTable & reduction_table,
+    const vector<unsigned int> & poly
+    ) const
+{
+  // kernels need the compact tables
+  if ( !reduction_table.compact_zech_table || poly.size() > count_kernel_max_poly_size )
+    return nullptr;
+
+  unsigned int tail_support = 0;
+  for ( size_t dx : this->tail_ixs )
+    if ( poly[dx] != reduction_table.prime_power_pred )
+      tail_support |= 1u << dx;
+  return evaluate_values_kernel(poly.size(), tail_support);
+}
+
+void
+CurveBlock::
+count_cpu(
+    const ReductionTable & reduction_table,
+    const vector<size_t> & curve_ixs,
+    const vector<vector<unsigned int>> & poly_coeff_exponents,
+    const shared_ptr<vector<int32_t>> orbit_representatives
+    )
+{
+  // We proceed in tiles of x. For each tile, the powers of x are computed once
+  // and then used for all curves, so that they and the lines of the tables
+  // that are accessed for them remain in cache.
+  //
+  // If vector instructions are available, curves are evaluated in groups,
+  // one curve in each lane, so that all lanes share the powers of x. Their
+  // coefficients are arranged as structure of arrays. This pays off in
+  // particular for small fields, where vectorizing in x leaves lanes idle.
+
+  unsigned int prime_exponent = reduction_table.prime_exponent;
+  unsigned int prime_power_pred = reduction_table.prime_power_pred;
+
+  const auto & exponent_reduction_table = *reduction_table.exponent_reduction_table;
+  const auto & incrementation_table = *reduction_table.incrementation_table;
+
+  // the fixed part of f(x) is shared by all curves of the block
+  auto prefix_values_shared = this->prefix_values(reduction_table);
+  const auto & prefix_values = *prefix_values_shared;
+
+  unsigned int nmb_xs = orbit_representatives ? orbit_representatives->size() : prime_power_pred;
+  unsigned int weight = orbit_representatives ? prime_exponent / this->table->prime_exponent : 1;
+
+  size_t tail_size = this->tail_ixs.size();
+  vector<unsigned int> xpws(tile_size * tail_size);
+  vector<unsigned int> tile_prefix_values(tile_size);
+  vector<tuple<unsigned int,unsigned int>> nmbs_points(curve_ixs.size(), make_tuple(0,0));
+
+  EvaluationSIMD simd =
+    reduction_table.count_variant() == CountVariantScalarTables ? EvaluationSIMDScalar : evaluation_simd();
+  size_t width = evaluation_simd_width(simd);
+  size_t nmb_lane_curves = simd == EvaluationSIMDScalar ? 0 : curve_ixs.size() / width * width;
+
+  vector<unsigned int> lane_coeff_exponents(nmb_lane_curves * (1 + tail_size));
+  vector<unsigned int> lane_nmbs_unramified(nmb_lane_curves, 0);
+  vector<unsigned int> lane_nmbs_ramified(nmb_lane_curves, 0);
+  // the remaining curves use kernels that are specialized to their support,
+  // which need the compact tables
+  const CompactZechEntry * zech_table =
+    reduction_table.compact_zech_table ? reduction_table.compact_zech_table->data() : nullptr;
+  vector<unsigned int> tail_coeff_exponents((curve_ixs.size() - nmb_lane_curves) * tail_size);
+  vector<CountTileKernel> tile_kernels;
+  for ( size_t cx = nmb_lane_curves; cx < curve_ixs.size(); ++cx ) {
+    auto tail_coeffs = tail_coeff_exponents.data() + (cx - nmb_lane_curves) * tail_size;
+    unsigned int tail_support = 0;
+    for ( size_t tx = 0; tx < tail_size; ++tx ) {
+      tail_coeffs[tx] = poly_coeff_exponents[cx][this->tail_ixs[tx]];
+      if ( tail_coeffs[tx] != prime_power_pred )
+        tail_support |= 1u << tx;
+    }
+    tile_kernels.push_back(zech_table ? count_tile_kernel(tail_size, tail_support) : nullptr);
+  }
+
+  for ( size_t cx = 0; cx < nmb_lane_curves; ++cx ) {
+    auto lane_coeffs = lane_coeff_exponents.data() + (cx / width) * width * (1 + tail_size) + cx % width;
+    lane_coeffs[0] = poly_coeff_exponents[cx][0];
+    for ( size_t tx = 0; tx < tail_size; ++tx )
+      lane_coeffs[(tx+1) * width] = poly_coeff_exponents[cx][this->tail_ixs[tx]];
+  }
+
+
+  for ( unsigned int ix_begin = 0; ix_begin < nmb_xs; ix_begin += tile_size ) {
+    unsigned int ix_end = min(ix_begin + tile_size, nmb_xs);
+
+    for ( unsigned int ix = ix_begin; ix < ix_end; ++ix ) {
+      unsigned int j = orbit_representatives ? (*orbit_representatives)[ix] : ix;
+
+      auto xpws_x = xpws.data() + (ix - ix_begin) * tail_size;
+      unsigned int xpw = 0;
+      for ( size_t tx = 0, dx = 0; tx < tail_size; ++tx ) {
+        for ( ; dx < this->tail_ixs[tx]; ++dx )
+          xpw = exponent_reduction_table[xpw + j];
+        xpws_x[tx] = xpw;
+      }
+
+      tile_prefix_values[ix - ix_begin] = prefix_values[j];
+    }
+
+    for ( size_t cx = 0; cx < nmb_lane_curves; cx += width )
+      evaluate_lanes_simd( simd, ix_end - ix_begin, tile_prefix_values.data(), xpws.data(), tail_size,
+                           lane_coeff_exponents.data() + cx * (1 + tail_size),
+                           prime_power_pred, exponent_reduction_table, incrementation_table,
+                           lane_nmbs_unramified.data() + cx, lane_nmbs_ramified.data() + cx );
+
+    for ( size_t cx = nmb_lane_curves; cx < curve_ixs.size(); ++cx ) {
+      const auto & poly = poly_coeff_exponents[cx];
+      unsigned int nmb_unramified = 0;
+      unsigned int nmb_ramified = 0;
+
+      auto kernel = tile_kernels[cx - nmb_lane_curves];
+      if ( kernel )
+        kernel( poly[0], tail_coeff_exponents.data() + (cx - nmb_lane_curves) * tail_size,
+                ix_end - ix_begin, tile_prefix_values.data(), xpws.data(),
+                prime_power_pred, zech_table, nmb_unramified, nmb_ramified );
+      else {
+        for ( unsigned int xx = 0; xx < ix_end - ix_begin; ++xx ) {
+          auto xpws_x = xpws.data() + xx * tail_size;
+
+          unsigned int f = add_exponents( poly[0], tile_prefix_values[xx],
+                                          prime_power_pred, exponent_reduction_table, incrementation_table );
+          for ( size_t tx = 0; tx < tail_size; ++tx ) {
+            unsigned int c = poly[this->tail_ixs[tx]];
+            if ( c != prime_power_pred ) // i.e. coefficient is not zero
+              f = add_exponents( f, exponent_reduction_table[c + xpws_x[tx]],
+                                 prime_power_pred, exponent_reduction_table, incrementation_table );
+          }
+
+          if ( f == prime_power_pred )
+            nmb_ramified += 1;
+          else if ( !(f & 1) )
+            nmb_unramified += 2;
+        }
+      }
+
+      get<0>(nmbs_points[cx]) += nmb_unramified;
+      get<1>(nmbs_points[cx]) += nmb_ramified;
+    }
+  }
+
+
+  for ( size_t cx = 0; cx < nmb_lane_curves; ++cx ) {
+    get<0>(nmbs_points[cx]) = lane_nmbs_unramified[cx];
+    get<1>(nmbs_points[cx]) = lane_nmbs_ramified[cx];
+  }
+
+  for ( size_t cx = 0; cx < curve_ixs.size(); ++cx ) {
+    auto & nmb_points = this->curves[curve_ixs[cx]].nmb_points[prime_exponent];
+    get<0>(nmb_points) += weight * get<0>(nmbs_points[cx]);
+    get<1>(nmb_points) += weight * get<1>(nmbs_points[cx]);
+  }
+}
+
+void
+CurveBlock::
+count_gray_code(
+    const ReductionTable & reduction_table,
+    const vector<size_t> & curve_ixs,
+    const shared_ptr<vector<int32_t>> orbit_representatives
+    )
+{
+  // We keep the exponents of f(a^j) for all j < q-1 and when passing from
+  // one position to the next add (c_new - c_old) x^k, which needs one Zech
+  // addition for each x. With vector instructions, the values of as many x
+  // as there are lanes are updated at once.
+
+  unsigned int prime_exponent = reduction_table.prime_exponent;
+  unsigned int prime_power_pred = reduction_table.prime_power_pred;
+
+  const auto & exponent_reduction_table = *reduction_table.exponent_reduction_table;
+  const auto & incrementation_table = *reduction_table.incrementation_table;
+
+  // conversion of exponents for the base field to the counting field
+  unsigned int base_prime_power_pred = this->table->prime_power_pred;
+  unsigned int exponent_factor = prime_power_pred / base_prime_power_pred;
+
+  // the exponent of -1
+  unsigned int minus_one_exponent = this->table->prime == 2 ? 0 : prime_power_pred / 2;
+
+  vector<bool> is_counted_curve(this->curves.size(), false);
+  for ( size_t cx : curve_ixs )
+    is_counted_curve[cx] = true;
+
+
+  vector<unsigned int> poly;
+  poly.reserve(this->gray_initial_position.size());
+  for ( unsigned int c : this->gray_initial_position )
+    poly.push_back(c != base_prime_power_pred ? exponent_factor * c : prime_power_pred);
+
+  auto prefix_values_shared = this->prefix_values(reduction_table);
+  const auto & prefix_values = *prefix_values_shared;
+
+  unsigned int nmb_xs = orbit_representatives ? orbit_representatives->size() : prime_power_pred;
+  unsigned int weight = orbit_representatives ? prime_exponent / this->table->prime_exponent : 1;
+
+  // the exponents of x^k for the varying coefficients, if x does not run through all of F_q^*
+  vector<vector<unsigned int>> varying_xpws(this->block.size());
+  if ( orbit_representatives )
+    for ( const auto & change : this->gray_changes ) {
+      size_t k = get<0>(change);
+      if ( !varying_xpws[k].empty() ) continue;
+
+      varying_xpws[k].reserve(nmb_xs);
+      for ( unsigned int j : *orbit_representatives )
+        varying_xpws[k].push_back(((uint64_t)k * j) % prime_power_pred);
+    }
+
+  EvaluationSIMD simd =
+    reduction_table.count_variant() == CountVariantScalarTables ? EvaluationSIMDScalar : evaluation_simd();
+  const int32_t * xs = orbit_representatives ? orbit_representatives->data() : nullptr;
+
+  vector<unsigned int> values(nmb_xs);
+  unsigned int ix_begin =
+    evaluate_values_simd( simd, poly[0], prefix_values.data(), poly, this->tail_ixs, xs, 0, nmb_xs,
+                          values.data(), prime_power_pred, exponent_reduction_table, incrementation_table );
+  auto values_kernel = this->values_kernel(reduction_table, poly);
+  if ( values_kernel )
+    values_kernel( poly[0], prefix_values.data(), poly.data(), xs, ix_begin, nmb_xs, values.data(),
+                   prime_power_pred, reduction_table.compact_zech_table->data() );
+  else
+    for ( unsigned int ix = ix_begin; ix < nmb_xs; ++ix ) {
+      unsigned int j = orbit_representatives ? (*orbit_representatives)[ix] : ix;
+      unsigned int f = add_exponents( poly[0], prefix_values[j],
+                                      prime_power_pred, exponent_reduction_table, incrementation_table );
+      unsigned int xpw = 0;
+      for ( size_t tx = 0, dx = 0; tx < this->tail_ixs.size(); ++tx ) {
+        for ( ; dx < this->tail_ixs[tx]; ++dx )
+          xpw = exponent_reduction_table[xpw + j];
+        unsigned int c = poly[this->tail_ixs[tx]];
+        if ( c != prime_power_pred )
+          f = add_exponents( f, exponent_reduction_table[c + xpw],
+                             prime_power_pred, exponent_reduction_table, incrementation_table );
+      }
+      values[ix] = f;
+    }
+
+
+  size_t cx = 0;
+  for ( size_t px = 0; ; ++px ) {
+    if ( this->gray_is_curve[px] ) {
+      if ( is_counted_curve[cx] ) {
+        unsigned int nmb_unramified = 0;
+        unsigned int nmb_ramified = 0;
+        unsigned int ix = count_values_simd( simd, values.data(), nmb_xs, prime_power_pred,
+                                             nmb_unramified, nmb_ramified );
+        for ( ; ix < nmb_xs; ++ix )
+          if ( values[ix] == prime_power_pred )
+            nmb_ramified += 1;
+          else if ( !(values[ix] & 1) )
+            nmb_unramified += 2;
+
+        auto & nmb_points = this->curves[cx].nmb_points[prime_exponent];
+        get<0>(nmb_points) += weight * nmb_unramified;
+        get<1>(nmb_points) += weight * nmb_ramified;
+      }
+      ++cx;
+    }
+
+    if ( px == this->gray_changes.size() )
+      break;
+
+
+    size_t k;
+    unsigned int c_old, c_new;
+    tie(k, c_old, c_new) = this->gray_changes[px];
+    c_old = c_old != base_prime_power_pred ? exponent_factor * c_old : prime_power_pred;
+    c_new = c_new != base_prime_power_pred ? exponent_factor * c_new : prime_power_pred;
+
+    // the exponent of c_new - c_old, which is nonzero
+    unsigned int diff;
+    if ( c_old == prime_power_pred )
+      diff = c_new;
+    else
+      diff = add_exponents( c_new, exponent_reduction_table[c_old + minus_one_exponent],
+                            prime_power_pred, exponent_reduction_table, incrementation_table );
+
+    if ( orbit_representatives ) {
+      const auto & xpws = varying_xpws[k];
+      unsigned int ix = add_term_simd( simd, diff, xpws.data(), nmb_xs, values.data(),
+                                       prime_power_pred, exponent_reduction_table, incrementation_table );
+      for ( ; ix < nmb_xs; ++ix )
+        values[ix] = add_exponents( values[ix], exponent_reduction_table[diff + xpws[ix]],
+                                    prime_power_pred, exponent_reduction_table, incrementation_table );
+    }
+    else {
+      unsigned int k_reduced = k % prime_power_pred;
+      unsigned int j = add_monomial_simd( simd, diff, k_reduced, values.data(),
+                                          prime_power_pred, exponent_reduction_table, incrementation_table );
+      for ( unsigned int xpw = ((uint64_t)j * k_reduced) % prime_power_pred; j < prime_power_pred; ++j ) {
+        values[j] = add_exponents( values[j], exponent_reduction_table[diff + xpw],
+                                   prime_power_pred, exponent_reduction_table, incrementation_table );
+        xpw += k_reduced;
+        if ( xpw >= prime_power_pred )
+          xpw -= prime_power_pred;
+      }
+    }
+  }
+}
+
+void
+CurveBlock::
+count_correlation(
+    const ReductionTable & reduction_table,
+    const vector<size_t> & curve_ixs,
+    const shared_ptr<vector<int32_t>> orbit_representatives
+    )
+{
+  // Write f = g + c with constant c in F_p. For each choice of the other
+  // coefficients, we tabulate the histogram of g(x) with respect to additive
+  // labels. Within each coset b + F_p, the number of x with g(x) + c a nonzero
+  // square is a cyclic correlation of length p of this histogram with the
+  // characteristic function of nonzero squares in b + F_p. It is computed for
+  // all c at once by one polynomial multiplication.
+
+  unsigned int prime = reduction_table.prime;
+  unsigned int prime_exponent = reduction_table.prime_exponent;
+  unsigned int prime_power = reduction_table.prime_power;
+  unsigned int prime_power_pred = reduction_table.prime_power_pred;
+
+  const auto & exponent_reduction_table = *reduction_table.exponent_reduction_table;
+  const auto & incrementation_table = *reduction_table.incrementation_table;
+  const auto & additive_table = *reduction_table.additive_table;
+  const auto & additive_table_inverse = *reduction_table.additive_table_inverse;
+
+  unsigned int base_prime_power_pred = this->table->prime_power_pred;
+  unsigned int exponent_factor = prime_power_pred / base_prime_power_pred;
+
+  // curves are looked up by their positions in the block, which unlike their
+  // coefficient exponents keep zero coefficients at the top
+  vector<bool> is_counted_curve(this->curves.size(), false);
+  for ( size_t cx : curve_ixs )
+    is_counted_curve[cx] = true;
+
+  map<vector<unsigned int>, size_t> curve_ixs_by_position;
+  vector<unsigned int> gray_position = this->gray_initial_position;
+  for ( size_t px = 0, cx = 0; ; ++px ) {
+    if ( this->gray_is_curve[px] ) {
+      if ( is_counted_curve[cx] )
+        curve_ixs_by_position[gray_position] = cx;
+      ++cx;
+    }
+
+    if ( px == this->gray_changes.size() )
+      break;
+    gray_position[get<0>(this->gray_changes[px])] = get<2>(this->gray_changes[px]);
+  }
+
+
+  // all entries of products are bounded by q-1
+  mp_limb_t modulus = n_nextprime(prime_power, 0);
+  size_t nmb_cosets = prime_power / prime;
+
+  // characteristic functions of nonzero squares on cosets, repeated twice
+  vector<nmod_poly_struct> squares(nmb_cosets);
+  for ( size_t wx = 0; wx < nmb_cosets; ++wx ) {
+    nmod_poly_init2(&squares[wx], modulus, 2*prime);
+    for ( size_t ux = 0; ux < 2*prime; ++ux ) {
+      unsigned int e = additive_table_inverse[wx*prime + ux % prime];
+      if ( e != prime_power_pred && !(e & 1) )
+        nmod_poly_set_coeff_ui(&squares[wx], ux, 1);
+    }
+  }
+
+  nmod_poly_t histogram_poly, product;
+  nmod_poly_init2(histogram_poly, modulus, prime);
+  nmod_poly_init(product, modulus);
+
+
+  unsigned int constant_lbd, constant_ubd;
+  tie(constant_lbd, constant_ubd) = this->block[0];
+  vuu_block nonconstant_block = this->block;
+  nonconstant_block[0] = make_tuple(constant_lbd, constant_lbd+1);
+
+  auto prefix_values_shared = this->prefix_values(reduction_table);
+  const auto & prefix_values = *prefix_values_shared;
+
+  unsigned int nmb_xs = orbit_representatives ? orbit_representatives->size() : prime_power_pred;
+  unsigned int weight = orbit_representatives ? prime_exponent / this->table->prime_exponent : 1;
+
+  EvaluationSIMD simd =
+    reduction_table.count_variant() == CountVariantScalarTables ? EvaluationSIMDScalar : evaluation_simd();
+  const int32_t * xs = orbit_representatives ? orbit_representatives->data() : nullptr;
+
+  vector<unsigned int> poly(this->block.size());
+  vector<unsigned int> values(nmb_xs);
+  vector<unsigned int> histogram(prime_power);
+  vector<unsigned int> nmbs_squares(prime);
+
+  for ( BlockIterator iter(nonconstant_block); !iter.is_end(); iter.step() ) {
+    auto position = iter.as_position();
+
+    bool has_curve = false;
+    for ( unsigned int c = constant_lbd; c < constant_ubd && !has_curve; ++c ) {
+      position[0] = c;
+      has_curve = curve_ixs_by_position.count(position) != 0;
+    }
+    if ( !has_curve )
+      continue;
+
+    for ( size_t dx : this->tail_ixs )
+      poly[dx] = position[dx] != base_prime_power_pred ? exponent_factor * position[dx] : prime_power_pred;
+
+    unsigned int ix_begin =
+      evaluate_values_simd( simd, prime_power_pred, prefix_values.data(), poly, this->tail_ixs, xs, 0, nmb_xs,
+                            values.data(), prime_power_pred, exponent_reduction_table, incrementation_table );
+    auto values_kernel = this->values_kernel(reduction_table, poly);
+    if ( values_kernel )
+      values_kernel( prime_power_pred, prefix_values.data(), poly.data(), xs, ix_begin, nmb_xs, values.data(),
+                     prime_power_pred, reduction_table.compact_zech_table->data() );
+    else
+      for ( unsigned int ix = ix_begin; ix < nmb_xs; ++ix ) {
+        unsigned int j = orbit_representatives ? (*orbit_representatives)[ix] : ix;
+        unsigned int g = prefix_values[j];
+        unsigned int xpw = 0;
+        for ( size_t tx = 0, dx = 0; tx < this->tail_ixs.size(); ++tx ) {
+          for ( ; dx < this->tail_ixs[tx]; ++dx )
+            xpw = exponent_reduction_table[xpw + j];
+          unsigned int c = poly[this->tail_ixs[tx]];
+          if ( c != prime_power_pred )
+            g = add_exponents( g, exponent_reduction_table[c + xpw],
+                               prime_power_pred, exponent_reduction_table, incrementation_table );
+        }
+        values[ix] = g;
+      }
+
+    fill(histogram.begin(), histogram.end(), 0);
+    for ( unsigned int g : values )
+      histogram[additive_table[g]] += weight;
+
+    fill(nmbs_squares.begin(), nmbs_squares.end(), 0);
+    for ( size_t wx = 0; wx < nmb_cosets; ++wx ) {
+      // the histogram on the coset is reversed, so that the correlation
+      // appears as coefficients p-1, ..., 2p-2 of the product
+      nmod_poly_zero(histogram_poly);
+      for ( size_t tx = 0; tx < prime; ++tx )
+        if ( histogram[wx*prime + tx] != 0 )
+          nmod_poly_set_coeff_ui(histogram_poly, prime-1-tx, histogram[wx*prime + tx]);
+      if ( nmod_poly_is_zero(histogram_poly) )
+        continue;
+
+      nmod_poly_mul(product, histogram_poly, &squares[wx]);
+      for ( size_t sx = 0; sx < prime; ++sx )
+        nmbs_squares[sx] += nmod_poly_get_coeff_ui(product, prime-1+sx);
+    }
+
+    for ( unsigned int c = constant_lbd; c < constant_ubd; ++c ) {
+      position[0] = c;
+      auto curve_ix_it = curve_ixs_by_position.find(position);
+      if ( curve_ix_it == curve_ixs_by_position.end() )
+        continue;
+
+      // the constant coefficient is s*1
+      unsigned int s = additive_table[c != base_prime_power_pred ? exponent_factor * c : prime_power_pred];
+
+      auto & nmb_points = this->curves[curve_ix_it->second].nmb_points[prime_exponent];
+      get<0>(nmb_points) += 2 * nmbs_squares[s];
+      get<1>(nmb_points) += histogram[(prime - s) % prime];
+    }
+  }
+
+
+  nmod_poly_clear(histogram_poly);
+  nmod_poly_clear(product);
+  for ( auto & square_poly : squares )
+    nmod_poly_clear(&square_poly);
+}
@@ -0,0 +1,143 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#ifndef _H_CURVE_BLOCK
+#define _H_CURVE_BLOCK
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "block_iterator.hh"
+#include "count_kernels.hh"
+#include "curve.hh"
+#include "fq_element_table.hh"
+#include "reduction_table.hh"
+
+
+using std::map;
+using std::shared_ptr;
+using std::tuple;
+using std::vector;
+
+
+// Values of the part of f(x) that is fixed in a block, which are shared by
+// consecutive blocks of the same enumerator branch. A cache must only be used
+// with curves over one base field.
+class CurveBlockPrefixCache
+{
+  public:
+    shared_ptr<const vector<unsigned int>>
+        find(unsigned int prime_exponent, const vector<unsigned int> & prefix) const;
+    void insert( unsigned int prime_exponent, const vector<unsigned int> & prefix,
+                 shared_ptr<const vector<unsigned int>> values );
+
+  private:
+    // for each prime exponent the most recent prefix and its values
+    map<unsigned int, tuple<vector<unsigned int>, shared_ptr<const vector<unsigned int>>>> entries;
+};
+
+class CurveBlock
+{
+  public:
+    // the curves of a block with squarefree right hand side; under projective
+    // normalization, curves of even degree with rational roots are omitted;
+    // given the enumeration of the block, only representatives of Frobenius
+    // orbits are kept
+    CurveBlock( shared_ptr<FqElementTable> table, const vuu_block & block,
+                CurveBlockCountImplementation implementation = CurveBlockCountImplementationCorrelation,
+                shared_ptr<CurveBlockPrefixCache> prefix_cache = shared_ptr<CurveBlockPrefixCache>(),
+                CurveIteratorNormalization normalization = CurveIteratorNormalizationAffine,
+                shared_ptr<const CurveIterator> galois_reduction = shared_ptr<const CurveIterator>() );
+
+    inline size_t size() const { return this->curves.size(); };
+    inline vector<Curve>::const_iterator begin() const { return this->curves.cbegin(); };
+    inline vector<Curve>::const_iterator end() const { return this->curves.cend(); };
+
+    // count all curves of the block at once; with several threads, each
+    // curve is counted on its own with the x split among them
+    void count( ReductionTable & table, unsigned int nmb_threads = 1,
+                const CurveChunkRunner & run_chunks = CurveChunkRunner() );
+    void inline count( const shared_ptr<ReductionTable> table, unsigned int nmb_threads = 1,
+                       const CurveChunkRunner & run_chunks = CurveChunkRunner() )
+    {
+      this->count(*table, nmb_threads, run_chunks);
+    };
+
+  protected:
+    const shared_ptr<FqElementTable> table;
+    vuu_block block;
+
+    CurveBlockCountImplementation implementation;
+
+    // the non-constant coefficients that are fixed in the block form the
+    // prefix, which we store as a polynomial with zeros at all other places;
+    // the tail are the non-constant coefficients that vary
+    vector<unsigned int> prefix_position;
+    vector<size_t> tail_ixs;
+    shared_ptr<CurveBlockPrefixCache> prefix_cache;
+
+    // curves are stored in the order of the Gray code enumeration of the block
+    vector<Curve> curves;
+
+    // the first position of the Gray code and the changes of the coefficient
+    // exponents (index, old exponent, new exponent) that lead from one position to the next;
+    // we record for each position whether it yields a curve with squarefree right hand side
+    vector<unsigned int> gray_initial_position;
+    vector<tuple<size_t,unsigned int,unsigned int>> gray_changes;
+    vector<bool> gray_is_curve;
+
+  private:
+    shared_ptr<const vector<unsigned int>> prefix_values(const ReductionTable & table);
+
+    // mark the constant coefficients that together with the non-constant
+    // coefficients of the position yield a right hand side that is not
+    // squarefree; return false if this has to be tested for each curve
+    bool non_squarefree_constants( const vector<unsigned int> & position,
+                                   vector<bool> & is_non_squarefree ) const;
+    // mark the constant coefficients that together with the non-constant
+    // coefficients of the position yield a right hand side with a root in F_q
+    void rational_root_constants( const vector<unsigned int> & position,
+                                  vector<bool> & has_rational_root ) const;
+
+    // the kernel that evaluates the terms of the tail with nonzero coefficient
+    // in poly, given as exponents for the reduction table, or null if there is none
+    EvaluateValuesKernel values_kernel( const ReductionTable & reduction_table,
+                                        const vector<unsigned int> & poly ) const;
+
+    // if orbit representatives are given, only they are evaluated and each
+    // of them is weighted by the size of its Frobenius orbit
+    void count_cpu( const ReductionTable & table, const vector<size_t> & curve_ixs,
+                    const vector<vector<unsigned int>> & poly_coeff_exponents,
+                    const shared_ptr<vector<int32_t>> orbit_representatives );
+    void count_gray_code( const ReductionTable & table, const vector<size_t> & curve_ixs,
+                          const shared_ptr<vector<int32_t>> orbit_representatives );
+    void count_correlation( const ReductionTable & table, const vector<size_t> & curve_ixs,
+                            const shared_ptr<vector<int32_t>> orbit_representatives );
+
+    // number of x that are treated at once in count_cpu
+    static const unsigned int tile_size;
+};
+
+#endif
@@ -34,9 +34,13 @@ CurveIterator(
     const FqElementTable & table,
     unsigned int genus,
     bool with_marked_point,
-    unsigned int package_size
+    unsigned int package_size,
+    CurveIteratorNormalization normalization
     ) :
-  prime ( table.prime )
+  prime ( table.prime ),
+  prime_exponent ( table.prime_exponent ),
+  prime_power_pred ( table.prime_power_pred ),
+  _normalization ( normalization )
 {
   if ( prime == 2 ) {
     cerr << "CurveIterator: "
@@ -49,6 +53,13 @@ CurveIterator(
          << "implemented only if genus is positive" << endl;
     throw;
   }
+
+  // a marked point already lies at infinity
+  if ( with_marked_point && normalization == CurveIteratorNormalizationProjective ) {
+    cerr << "CurveIterator: "
+         << "projective normalization is implemented only without marked point" << endl;
+    throw;
+  }
     
 
   for ( unsigned int degree = 2*genus + 1; degree < (with_marked_point ? 2*genus + 2 : 2*genus + 3); ++degree ) {
@@ -212,6 +223,42 @@ is_end()
   return ( this->enumerator_it == this->enumerators.end() );
 }
 
+unsigned int
+CurveIterator::
+galois_multiplicity(
+    const vector<unsigned int> & position
+    )
+  const
+{
+  unsigned int galois_mult = 1;
+
+  vector<unsigned int> conjugate = position;
+  for ( unsigned int fx = 1; fx < this->prime_exponent; ++fx ) {
+    // the zero index q-1 is fixed
+    for ( auto & c : conjugate )
+      if ( c != this->prime_power_pred )
+        c = ((unsigned long)c * this->prime) % this->prime_power_pred;
+
+    if ( conjugate == position )
+      break;
+
+    bool is_enumerated = false;
+    for ( const auto & enumerator : this->enumerators )
+      if ( enumerator.contains(conjugate) ) {
+        is_enumerated = true;
+        break;
+      }
+    if ( !is_enumerated )
+      continue;
+
+    if ( conjugate < position )
+      return 0;
+    ++galois_mult;
+  }
+
+  return galois_mult;
+}
+
 void
 CurveIterator::
 multiplicity(
@@ -308,3 +355,40 @@ multiplicity(
     }
   }
 }
+
+void
+CurveIterator::
+projective_multiplicity(
+    fmpq_t mult,
+    unsigned int prime,
+    unsigned int prime_power,
+    vector<unsigned int> coeff_support,
+    unsigned int nmb_rational_ramification_points
+    )
+{
+  // Curves of even degree without rational ramification points are weighted
+  // as in the affine case. A curve with r > 0 rational ramification points is
+  // isomorphic to a curve of odd degree for each choice of one of them that is
+  // moved to infinity. Since PGL_2 acts transitively on the q+1 rational
+  // points of the projective line, each curve of odd degree stands for
+  // (q+1)/r times its affine orbit. The ramification type of a curve
+  // determines r, so the sums of weights over all curves of one type are
+  // integral. Curves of even degree with rational ramification points are
+  // represented by odd ones and have weight zero.
+  unsigned int degree = coeff_support.back();
+
+  fmpq_zero(mult);
+  if ( degree % 2 == 0 && nmb_rational_ramification_points != 0 )
+    return;
+
+  CurveIterator::multiplicity(fmpq_numref(mult), prime, prime_power, coeff_support);
+  if ( degree % 2 == 0 )
+    return;
+
+  fmpz_t factor;
+  fmpz_init_set_ui(factor, prime_power + 1);
+  fmpq_mul_fmpz(mult, mult, factor);
+  fmpz_set_ui(factor, nmb_rational_ramification_points);
+  fmpq_div_fmpz(mult, mult, factor);
+  fmpz_clear(factor);
+}
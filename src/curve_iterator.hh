@@ -24,6 +24,8 @@
 #ifndef _H_CURVE_ITERATOR
 #define _H_CURVE_ITERATOR
 
+#include <flint/fmpq.h>
+#include <flint/fmpz.h>
 #include <memory>
 #include <vector>
 #include <tuple>
@@ -37,6 +39,16 @@ using std::vector;
 using std::tuple;
 
 
+enum CurveIteratorNormalization
+{
+  // normal forms under substitutions x -> b_3 x + b_1 and scaling by squares
+  CurveIteratorNormalizationAffine,
+  // normal forms under PGL_2: if a curve has a rational ramification point, it
+  // is moved to infinity, so that only curves of even degree without rational
+  // ramification points are enumerated in addition to the ones of odd degree
+  CurveIteratorNormalizationProjective
+};
+
 class CurveIterator
 {
   public:
@@ -44,7 +56,8 @@ class CurveIterator
       const FqElementTable & table,
       unsigned int genus,
       bool with_marked_point,
-      unsigned int package_size
+      unsigned int package_size,
+      CurveIteratorNormalization normalization = CurveIteratorNormalizationAffine
     );
 
     CurveIterator const& step();
@@ -55,10 +68,26 @@ class CurveIterator
 
     BlockIterator inline as_block_enumerator() { return this->enumerator_it->as_block_enumerator(); };
 
+    inline CurveIteratorNormalization normalization() const { return this->_normalization; };
+
+    // Frobenius acts on coefficient exponents by multiplication by the prime.
+    // Among the enumerated positions of a Frobenius orbit, the least one is
+    // its representative, which stands for all of them. Return their number
+    // for a representative and zero for other positions.
+    unsigned int galois_multiplicity(const vector<unsigned int> & position) const;
+
     static void multiplicity(fmpz_t mult, unsigned int prime, unsigned int prime_power, vector<unsigned int> coeff_support);
+    // the weight of a curve under projective normalization, which depends on
+    // the number of rational ramification points including infinity
+    static void projective_multiplicity( fmpq_t mult, unsigned int prime, unsigned int prime_power,
+                                         vector<unsigned int> coeff_support,
+                                         unsigned int nmb_rational_ramification_points );
 
   private:
     unsigned int prime;
+    unsigned int prime_exponent;
+    unsigned int prime_power_pred;
+    CurveIteratorNormalization _normalization;
 
     vector<BlockIterator> enumerators;
     vector<BlockIterator>::iterator enumerator_it;
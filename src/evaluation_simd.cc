@@ -0,0 +1,1089 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <iostream>
+
+#include "evaluation_simd.hh"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #define HYCU_EVALUATION_X86
+  #include <immintrin.h>
+#endif
+
+
+using namespace std;
+
+
+static
+EvaluationSIMD
+supported_evaluation_simd()
+{
+#ifdef HYCU_EVALUATION_X86
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports("avx512f") )
+    return EvaluationSIMDAVX512;
+  if ( __builtin_cpu_supports("avx2") )
+    return EvaluationSIMDAVX2;
+#endif
+  return EvaluationSIMDScalar;
+}
+
+static EvaluationSIMD evaluation_simd_selected = supported_evaluation_simd();
+
+EvaluationSIMD
+evaluation_simd()
+{
+  return evaluation_simd_selected;
+}
+
+void
+set_evaluation_simd(
+    EvaluationSIMD simd
+    )
+{
+  if ( simd > supported_evaluation_simd() ) {
+    cerr << "set_evaluation_simd: instruction set not supported by cpu: " << simd << endl;
+    throw;
+  }
+  evaluation_simd_selected = simd;
+}
+
+unsigned int
+evaluation_simd_width(
+    EvaluationSIMD simd
+    )
+{
+  if ( simd == EvaluationSIMDAVX512 )
+    return 16;
+  if ( simd == EvaluationSIMDAVX2 )
+    return 8;
+  return 1;
+}
+
+
+#ifdef HYCU_EVALUATION_X86
+
+// The vectorized Zech addition follows add_exponents. All table indices
+// stay within the tables also for lanes in which the result is discarded,
+// since the characteristic is odd.
+
+__attribute__((target("avx2")))
+static inline
+__m256i
+add_exponents_avx2(
+    __m256i f,
+    __m256i g,
+    __m256i zero_index,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  __m256i lower = _mm256_min_epi32(f, g);
+  __m256i upper = _mm256_max_epi32(f, g);
+  __m256i inc = _mm256_i32gather_epi32(incrementation_table, _mm256_sub_epi32(upper, lower), 4);
+  __m256i sum = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(lower, inc), 4);
+
+  sum = _mm256_blendv_epi8(sum, zero_index, _mm256_cmpeq_epi32(inc, zero_index));
+  sum = _mm256_blendv_epi8(sum, g, _mm256_cmpeq_epi32(f, zero_index));
+  sum = _mm256_blendv_epi8(sum, f, _mm256_cmpeq_epi32(g, zero_index));
+  return sum;
+}
+
+// count ramified points as 1 and unramified points as 1 in each lane
+__attribute__((target("avx2")))
+static inline
+void
+record_points_avx2(
+    __m256i f,
+    __m256i zero_index,
+    __m256i & nmbs_unramified,
+    __m256i & nmbs_ramified
+    )
+{
+  __m256i is_zero = _mm256_cmpeq_epi32(f, zero_index);
+  __m256i is_even = _mm256_cmpeq_epi32(_mm256_and_si256(f, _mm256_set1_epi32(1)), _mm256_setzero_si256());
+  nmbs_ramified = _mm256_sub_epi32(nmbs_ramified, is_zero);
+  nmbs_unramified = _mm256_sub_epi32(nmbs_unramified, _mm256_andnot_si256(is_zero, is_even));
+}
+
+__attribute__((target("avx2")))
+static inline
+unsigned int
+horizontal_sum_avx2(
+    __m256i v
+    )
+{
+  alignas(32) uint32_t lanes[8];
+  _mm256_store_si256((__m256i*)lanes, v);
+  unsigned int sum = 0;
+  for ( size_t lx = 0; lx < 8; ++lx )
+    sum += lanes[lx];
+  return sum;
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+evaluate_even_odd_avx2(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int poly_size = poly_coeff_exponents.size();
+
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+  const __m256i minus_one_exponent = _mm256_set1_epi32(prime_power_pred / 2);
+  const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  __m256i nmbs_unramified = _mm256_setzero_si256();
+  __m256i nmbs_ramified = _mm256_setzero_si256();
+
+  unsigned int x;
+  for ( x = begin; x + 8 <= end; x += 8 ) {
+    __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(x), lane_offsets);
+
+    __m256i f_even = _mm256_set1_epi32(poly_coeff_exponents[0]);
+    __m256i f_odd = zero_index;
+    __m256i xpws = _mm256_setzero_si256();
+    for ( unsigned int dx = 1; dx < poly_size; ++dx ) {
+      xpws = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(xpws, xs), 4);
+      if ( poly_coeff_exponents[dx] == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m256i terms = _mm256_i32gather_epi32( exponent_reduction_table,
+                          _mm256_add_epi32(xpws, _mm256_set1_epi32(poly_coeff_exponents[dx])), 4 );
+      if ( dx & 1 )
+        f_odd = add_exponents_avx2(f_odd, terms, zero_index, exponent_reduction_table, incrementation_table);
+      else
+        f_even = add_exponents_avx2(f_even, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    __m256i f = add_exponents_avx2(f_even, f_odd, zero_index, exponent_reduction_table, incrementation_table);
+    record_points_avx2(f, zero_index, nmbs_unramified, nmbs_ramified);
+
+    __m256i f_odd_negated = _mm256_i32gather_epi32( exponent_reduction_table,
+                                _mm256_add_epi32(f_odd, minus_one_exponent), 4 );
+    f_odd_negated = _mm256_blendv_epi8(f_odd_negated, zero_index, _mm256_cmpeq_epi32(f_odd, zero_index));
+    f = add_exponents_avx2(f_even, f_odd_negated, zero_index, exponent_reduction_table, incrementation_table);
+    record_points_avx2(f, zero_index, nmbs_unramified, nmbs_ramified);
+  }
+
+  nmb_unramified += 2 * horizontal_sum_avx2(nmbs_unramified);
+  nmb_ramified += horizontal_sum_avx2(nmbs_ramified);
+  return x;
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+evaluate_avx2(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    const vector<int32_t> & xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int poly_size = poly_coeff_exponents.size();
+
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+
+  __m256i nmbs_unramified = _mm256_setzero_si256();
+  __m256i nmbs_ramified = _mm256_setzero_si256();
+
+  unsigned int ix;
+  for ( ix = begin; ix + 8 <= end; ix += 8 ) {
+    __m256i xvs = _mm256_loadu_si256((const __m256i*)(xs.data() + ix));
+
+    __m256i f = _mm256_set1_epi32(poly_coeff_exponents[0]);
+    __m256i xpws = _mm256_setzero_si256();
+    for ( unsigned int dx = 1; dx < poly_size; ++dx ) {
+      xpws = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(xpws, xvs), 4);
+      if ( poly_coeff_exponents[dx] == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m256i terms = _mm256_i32gather_epi32( exponent_reduction_table,
+                          _mm256_add_epi32(xpws, _mm256_set1_epi32(poly_coeff_exponents[dx])), 4 );
+      f = add_exponents_avx2(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    record_points_avx2(f, zero_index, nmbs_unramified, nmbs_ramified);
+  }
+
+  nmb_unramified += 2 * horizontal_sum_avx2(nmbs_unramified);
+  nmb_ramified += horizontal_sum_avx2(nmbs_ramified);
+  return ix;
+}
+
+__attribute__((target("avx2")))
+static
+void
+evaluate_lanes_avx2(
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int tail_size,
+    const unsigned int * coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    unsigned int * nmbs_unramified,
+    unsigned int * nmbs_ramified
+    )
+{
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+  const __m256i constants = _mm256_loadu_si256((const __m256i*)coeff_exponents);
+
+  __m256i nmbs_unramified_lanes = _mm256_setzero_si256();
+  __m256i nmbs_ramified_lanes = _mm256_setzero_si256();
+
+  for ( unsigned int xx = 0; xx < nmb_xs; ++xx ) {
+    __m256i f = add_exponents_avx2( _mm256_set1_epi32(prefix_values[xx]), constants, zero_index,
+                                    exponent_reduction_table, incrementation_table );
+
+    const unsigned int * xpws_x = xpws + xx * tail_size;
+    for ( unsigned int tx = 0; tx < tail_size; ++tx ) {
+      __m256i coeffs = _mm256_loadu_si256((const __m256i*)(coeff_exponents + 8 * (tx+1)));
+      __m256i terms = _mm256_i32gather_epi32( exponent_reduction_table,
+                          _mm256_add_epi32(coeffs, _mm256_set1_epi32(xpws_x[tx])), 4 );
+      terms = _mm256_blendv_epi8(terms, zero_index, _mm256_cmpeq_epi32(coeffs, zero_index));
+      f = add_exponents_avx2(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    record_points_avx2(f, zero_index, nmbs_unramified_lanes, nmbs_ramified_lanes);
+  }
+
+  alignas(32) uint32_t lanes_unramified[8];
+  alignas(32) uint32_t lanes_ramified[8];
+  _mm256_store_si256((__m256i*)lanes_unramified, nmbs_unramified_lanes);
+  _mm256_store_si256((__m256i*)lanes_ramified, nmbs_ramified_lanes);
+  for ( size_t lx = 0; lx < 8; ++lx ) {
+    nmbs_unramified[lx] += 2 * lanes_unramified[lx];
+    nmbs_ramified[lx] += lanes_ramified[lx];
+  }
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+evaluate_values_avx2(
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const vector<size_t> & tail_ixs,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+  const __m256i constant = _mm256_set1_epi32(constant_exponent);
+  const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  unsigned int ix;
+  for ( ix = begin; ix + 8 <= end; ix += 8 ) {
+    __m256i xvs = xs ? _mm256_loadu_si256((const __m256i*)(xs + ix))
+                     : _mm256_add_epi32(_mm256_set1_epi32(ix), lane_offsets);
+
+    __m256i f = _mm256_i32gather_epi32((const int*)prefix_values, xvs, 4);
+    f = add_exponents_avx2(f, constant, zero_index, exponent_reduction_table, incrementation_table);
+
+    __m256i xpws = _mm256_setzero_si256();
+    for ( size_t tx = 0, dx = 0; tx < tail_ixs.size(); ++tx ) {
+      for ( ; dx < tail_ixs[tx]; ++dx )
+        xpws = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(xpws, xvs), 4);
+      unsigned int c = poly_coeff_exponents[tail_ixs[tx]];
+      if ( c == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m256i terms = _mm256_i32gather_epi32( exponent_reduction_table,
+                          _mm256_add_epi32(xpws, _mm256_set1_epi32(c)), 4 );
+      f = add_exponents_avx2(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    _mm256_storeu_si256((__m256i*)(values + ix), f);
+  }
+
+  return ix;
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+add_monomial_avx2(
+    unsigned int term_exponent,
+    unsigned int k_reduced,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+  const __m256i term = _mm256_set1_epi32(term_exponent);
+  // the exponents j k of x^k advance by 8 k modulo q-1 from one vector to the next
+  const __m256i step = _mm256_set1_epi32(((uint64_t)8 * k_reduced) % prime_power_pred);
+
+  alignas(32) uint32_t initial_xpws[8];
+  for ( size_t lx = 0; lx < 8; ++lx )
+    initial_xpws[lx] = ((uint64_t)lx * k_reduced) % prime_power_pred;
+  __m256i xpws = _mm256_load_si256((const __m256i*)initial_xpws);
+
+  unsigned int j;
+  for ( j = 0; j + 8 <= prime_power_pred; j += 8 ) {
+    __m256i terms = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(xpws, term), 4);
+    __m256i f = _mm256_loadu_si256((const __m256i*)(values + j));
+    f = add_exponents_avx2(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    _mm256_storeu_si256((__m256i*)(values + j), f);
+
+    xpws = _mm256_add_epi32(xpws, step);
+    xpws = _mm256_min_epu32(xpws, _mm256_sub_epi32(xpws, zero_index));
+  }
+
+  return j;
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+add_term_avx2(
+    unsigned int term_exponent,
+    const unsigned int * xpws,
+    unsigned int nmb_xs,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+  const __m256i term = _mm256_set1_epi32(term_exponent);
+
+  unsigned int ix;
+  for ( ix = 0; ix + 8 <= nmb_xs; ix += 8 ) {
+    __m256i xpws_x = _mm256_loadu_si256((const __m256i*)(xpws + ix));
+    __m256i terms = _mm256_i32gather_epi32(exponent_reduction_table, _mm256_add_epi32(xpws_x, term), 4);
+    __m256i f = _mm256_loadu_si256((const __m256i*)(values + ix));
+    f = add_exponents_avx2(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    _mm256_storeu_si256((__m256i*)(values + ix), f);
+  }
+
+  return ix;
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+count_values_avx2(
+    const unsigned int * values,
+    unsigned int nmb_xs,
+    unsigned int prime_power_pred,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  const __m256i zero_index = _mm256_set1_epi32(prime_power_pred);
+
+  __m256i nmbs_unramified = _mm256_setzero_si256();
+  __m256i nmbs_ramified = _mm256_setzero_si256();
+
+  unsigned int ix;
+  for ( ix = 0; ix + 8 <= nmb_xs; ix += 8 )
+    record_points_avx2( _mm256_loadu_si256((const __m256i*)(values + ix)), zero_index,
+                        nmbs_unramified, nmbs_ramified );
+
+  nmb_unramified += 2 * horizontal_sum_avx2(nmbs_unramified);
+  nmb_ramified += horizontal_sum_avx2(nmbs_ramified);
+  return ix;
+}
+
+// reduce t < 2^32 modulo a prime p < 2^16 with m = floor(2^32 / p)
+__attribute__((target("avx2")))
+static inline
+__m256i
+reduce_barrett_avx2(
+    __m256i t,
+    __m256i prime,
+    __m256i multiplier
+    )
+{
+  __m256i quotients_even = _mm256_srli_epi64(_mm256_mul_epu32(t, multiplier), 32);
+  __m256i quotients_odd = _mm256_mul_epu32(_mm256_srli_epi64(t, 32), multiplier);
+  __m256i quotients = _mm256_blend_epi32(quotients_even, quotients_odd, 0xAA);
+
+  // the remainder is less than 2p
+  __m256i remainders = _mm256_sub_epi32(t, _mm256_mullo_epi32(quotients, prime));
+  return _mm256_min_epu32(remainders, _mm256_sub_epi32(remainders, prime));
+}
+
+__attribute__((target("avx2")))
+static
+unsigned int
+evaluate_prime_field_avx2(
+    const vector<unsigned int> & poly_coeffs,
+    unsigned int prime,
+    const uint32_t * quadratic_residues,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  const __m256i primes = _mm256_set1_epi32(prime);
+  const __m256i multiplier = _mm256_set1_epi32((uint32_t)((1ull << 32) / prime));
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bit_index_mask = _mm256_set1_epi32(31);
+
+  __m256i nmbs_unramified = _mm256_setzero_si256();
+  __m256i nmbs_ramified = _mm256_setzero_si256();
+
+  unsigned int x = 1;
+  for ( ; x + 8 <= prime; x += 8 ) {
+    __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0,1,2,3,4,5,6,7));
+
+    __m256i f = _mm256_set1_epi32(poly_coeffs.back());
+    for ( size_t dx = poly_coeffs.size() - 1; dx-- > 0; )
+      f = reduce_barrett_avx2( _mm256_add_epi32(_mm256_mullo_epi32(f, xs), _mm256_set1_epi32(poly_coeffs[dx])),
+                               primes, multiplier );
+
+    __m256i words = _mm256_i32gather_epi32((const int*)quadratic_residues, _mm256_srli_epi32(f, 5), 4);
+    __m256i is_square = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(f, bit_index_mask)), one);
+    nmbs_unramified = _mm256_add_epi32(nmbs_unramified, is_square);
+    nmbs_ramified = _mm256_sub_epi32(nmbs_ramified, _mm256_cmpeq_epi32(f, _mm256_setzero_si256()));
+  }
+
+  nmb_unramified += 2 * horizontal_sum_avx2(nmbs_unramified);
+  nmb_ramified += horizontal_sum_avx2(nmbs_ramified);
+  return x;
+}
+
+
+__attribute__((target("avx512f")))
+static inline
+__m512i
+add_exponents_avx512(
+    __m512i f,
+    __m512i g,
+    __m512i zero_index,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  __m512i lower = _mm512_min_epi32(f, g);
+  __m512i upper = _mm512_max_epi32(f, g);
+  __m512i inc = _mm512_i32gather_epi32(_mm512_sub_epi32(upper, lower), incrementation_table, 4);
+  __m512i sum = _mm512_i32gather_epi32(_mm512_add_epi32(lower, inc), exponent_reduction_table, 4);
+
+  sum = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(inc, zero_index), sum, zero_index);
+  sum = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(f, zero_index), sum, g);
+  sum = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(g, zero_index), sum, f);
+  return sum;
+}
+
+__attribute__((target("avx512f")))
+static inline
+void
+record_points_avx512(
+    __m512i f,
+    __m512i zero_index,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  __mmask16 is_zero = _mm512_cmpeq_epi32_mask(f, zero_index);
+  __mmask16 is_odd = _mm512_test_epi32_mask(f, _mm512_set1_epi32(1));
+  nmb_ramified += __builtin_popcount(is_zero);
+  nmb_unramified += __builtin_popcount((~is_zero & ~is_odd) & 0xffff);
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+evaluate_even_odd_avx512(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int poly_size = poly_coeff_exponents.size();
+
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+  const __m512i minus_one_exponent = _mm512_set1_epi32(prime_power_pred / 2);
+  const __m512i lane_offsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+  unsigned int nmb_unramified_lanes = 0;
+  unsigned int nmb_ramified_lanes = 0;
+
+  unsigned int x;
+  for ( x = begin; x + 16 <= end; x += 16 ) {
+    __m512i xs = _mm512_add_epi32(_mm512_set1_epi32(x), lane_offsets);
+
+    __m512i f_even = _mm512_set1_epi32(poly_coeff_exponents[0]);
+    __m512i f_odd = zero_index;
+    __m512i xpws = _mm512_setzero_si512();
+    for ( unsigned int dx = 1; dx < poly_size; ++dx ) {
+      xpws = _mm512_i32gather_epi32(_mm512_add_epi32(xpws, xs), exponent_reduction_table, 4);
+      if ( poly_coeff_exponents[dx] == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m512i terms = _mm512_i32gather_epi32(
+                          _mm512_add_epi32(xpws, _mm512_set1_epi32(poly_coeff_exponents[dx])),
+                          exponent_reduction_table, 4 );
+      if ( dx & 1 )
+        f_odd = add_exponents_avx512(f_odd, terms, zero_index, exponent_reduction_table, incrementation_table);
+      else
+        f_even = add_exponents_avx512(f_even, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    __m512i f = add_exponents_avx512(f_even, f_odd, zero_index, exponent_reduction_table, incrementation_table);
+    record_points_avx512(f, zero_index, nmb_unramified_lanes, nmb_ramified_lanes);
+
+    __m512i f_odd_negated = _mm512_i32gather_epi32( _mm512_add_epi32(f_odd, minus_one_exponent),
+                                                    exponent_reduction_table, 4 );
+    f_odd_negated = _mm512_mask_blend_epi32( _mm512_cmpeq_epi32_mask(f_odd, zero_index),
+                                             f_odd_negated, zero_index );
+    f = add_exponents_avx512(f_even, f_odd_negated, zero_index, exponent_reduction_table, incrementation_table);
+    record_points_avx512(f, zero_index, nmb_unramified_lanes, nmb_ramified_lanes);
+  }
+
+  nmb_unramified += 2 * nmb_unramified_lanes;
+  nmb_ramified += nmb_ramified_lanes;
+  return x;
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+evaluate_avx512(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    const vector<int32_t> & xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  unsigned int poly_size = poly_coeff_exponents.size();
+
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+
+  unsigned int nmb_unramified_lanes = 0;
+  unsigned int nmb_ramified_lanes = 0;
+
+  unsigned int ix;
+  for ( ix = begin; ix + 16 <= end; ix += 16 ) {
+    __m512i xvs = _mm512_loadu_si512((const void*)(xs.data() + ix));
+
+    __m512i f = _mm512_set1_epi32(poly_coeff_exponents[0]);
+    __m512i xpws = _mm512_setzero_si512();
+    for ( unsigned int dx = 1; dx < poly_size; ++dx ) {
+      xpws = _mm512_i32gather_epi32(_mm512_add_epi32(xpws, xvs), exponent_reduction_table, 4);
+      if ( poly_coeff_exponents[dx] == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m512i terms = _mm512_i32gather_epi32(
+                          _mm512_add_epi32(xpws, _mm512_set1_epi32(poly_coeff_exponents[dx])),
+                          exponent_reduction_table, 4 );
+      f = add_exponents_avx512(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    record_points_avx512(f, zero_index, nmb_unramified_lanes, nmb_ramified_lanes);
+  }
+
+  nmb_unramified += 2 * nmb_unramified_lanes;
+  nmb_ramified += nmb_ramified_lanes;
+  return ix;
+}
+
+__attribute__((target("avx512f")))
+static
+void
+evaluate_lanes_avx512(
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int tail_size,
+    const unsigned int * coeff_exponents,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table,
+    unsigned int * nmbs_unramified,
+    unsigned int * nmbs_ramified
+    )
+{
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i constants = _mm512_loadu_si512((const void*)coeff_exponents);
+
+  __m512i nmbs_unramified_lanes = _mm512_setzero_si512();
+  __m512i nmbs_ramified_lanes = _mm512_setzero_si512();
+
+  for ( unsigned int xx = 0; xx < nmb_xs; ++xx ) {
+    __m512i f = add_exponents_avx512( _mm512_set1_epi32(prefix_values[xx]), constants, zero_index,
+                                      exponent_reduction_table, incrementation_table );
+
+    const unsigned int * xpws_x = xpws + xx * tail_size;
+    for ( unsigned int tx = 0; tx < tail_size; ++tx ) {
+      __m512i coeffs = _mm512_loadu_si512((const void*)(coeff_exponents + 16 * (tx+1)));
+      __m512i terms = _mm512_i32gather_epi32( _mm512_add_epi32(coeffs, _mm512_set1_epi32(xpws_x[tx])),
+                                              exponent_reduction_table, 4 );
+      terms = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(coeffs, zero_index), terms, zero_index);
+      f = add_exponents_avx512(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    __mmask16 is_zero = _mm512_cmpeq_epi32_mask(f, zero_index);
+    __mmask16 is_odd = _mm512_test_epi32_mask(f, one);
+    nmbs_ramified_lanes = _mm512_mask_add_epi32(nmbs_ramified_lanes, is_zero, nmbs_ramified_lanes, one);
+    nmbs_unramified_lanes = _mm512_mask_add_epi32( nmbs_unramified_lanes, ~(is_zero | is_odd),
+                                                   nmbs_unramified_lanes, one );
+  }
+
+  alignas(64) uint32_t lanes_unramified[16];
+  alignas(64) uint32_t lanes_ramified[16];
+  _mm512_store_si512((void*)lanes_unramified, nmbs_unramified_lanes);
+  _mm512_store_si512((void*)lanes_ramified, nmbs_ramified_lanes);
+  for ( size_t lx = 0; lx < 16; ++lx ) {
+    nmbs_unramified[lx] += 2 * lanes_unramified[lx];
+    nmbs_ramified[lx] += lanes_ramified[lx];
+  }
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+evaluate_values_avx512(
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const vector<size_t> & tail_ixs,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+  const __m512i constant = _mm512_set1_epi32(constant_exponent);
+  const __m512i lane_offsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+  unsigned int ix;
+  for ( ix = begin; ix + 16 <= end; ix += 16 ) {
+    __m512i xvs = xs ? _mm512_loadu_si512((const void*)(xs + ix))
+                     : _mm512_add_epi32(_mm512_set1_epi32(ix), lane_offsets);
+
+    __m512i f = _mm512_i32gather_epi32(xvs, (const int*)prefix_values, 4);
+    f = add_exponents_avx512(f, constant, zero_index, exponent_reduction_table, incrementation_table);
+
+    __m512i xpws = _mm512_setzero_si512();
+    for ( size_t tx = 0, dx = 0; tx < tail_ixs.size(); ++tx ) {
+      for ( ; dx < tail_ixs[tx]; ++dx )
+        xpws = _mm512_i32gather_epi32(_mm512_add_epi32(xpws, xvs), exponent_reduction_table, 4);
+      unsigned int c = poly_coeff_exponents[tail_ixs[tx]];
+      if ( c == prime_power_pred ) // i.e. coefficient is zero
+        continue;
+
+      __m512i terms = _mm512_i32gather_epi32( _mm512_add_epi32(xpws, _mm512_set1_epi32(c)),
+                                              exponent_reduction_table, 4 );
+      f = add_exponents_avx512(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    }
+
+    _mm512_storeu_si512((void*)(values + ix), f);
+  }
+
+  return ix;
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+add_monomial_avx512(
+    unsigned int term_exponent,
+    unsigned int k_reduced,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+  const __m512i term = _mm512_set1_epi32(term_exponent);
+  const __m512i step = _mm512_set1_epi32(((uint64_t)16 * k_reduced) % prime_power_pred);
+
+  alignas(64) uint32_t initial_xpws[16];
+  for ( size_t lx = 0; lx < 16; ++lx )
+    initial_xpws[lx] = ((uint64_t)lx * k_reduced) % prime_power_pred;
+  __m512i xpws = _mm512_load_si512((const void*)initial_xpws);
+
+  unsigned int j;
+  for ( j = 0; j + 16 <= prime_power_pred; j += 16 ) {
+    __m512i terms = _mm512_i32gather_epi32(_mm512_add_epi32(xpws, term), exponent_reduction_table, 4);
+    __m512i f = _mm512_loadu_si512((const void*)(values + j));
+    f = add_exponents_avx512(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    _mm512_storeu_si512((void*)(values + j), f);
+
+    xpws = _mm512_add_epi32(xpws, step);
+    xpws = _mm512_min_epu32(xpws, _mm512_sub_epi32(xpws, zero_index));
+  }
+
+  return j;
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+add_term_avx512(
+    unsigned int term_exponent,
+    const unsigned int * xpws,
+    unsigned int nmb_xs,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const int32_t * exponent_reduction_table,
+    const int32_t * incrementation_table
+    )
+{
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+  const __m512i term = _mm512_set1_epi32(term_exponent);
+
+  unsigned int ix;
+  for ( ix = 0; ix + 16 <= nmb_xs; ix += 16 ) {
+    __m512i xpws_x = _mm512_loadu_si512((const void*)(xpws + ix));
+    __m512i terms = _mm512_i32gather_epi32(_mm512_add_epi32(xpws_x, term), exponent_reduction_table, 4);
+    __m512i f = _mm512_loadu_si512((const void*)(values + ix));
+    f = add_exponents_avx512(f, terms, zero_index, exponent_reduction_table, incrementation_table);
+    _mm512_storeu_si512((void*)(values + ix), f);
+  }
+
+  return ix;
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+count_values_avx512(
+    const unsigned int * values,
+    unsigned int nmb_xs,
+    unsigned int prime_power_pred,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  const __m512i zero_index = _mm512_set1_epi32(prime_power_pred);
+
+  unsigned int nmb_unramified_lanes = 0;
+  unsigned int nmb_ramified_lanes = 0;
+
+  unsigned int ix;
+  for ( ix = 0; ix + 16 <= nmb_xs; ix += 16 )
+    record_points_avx512( _mm512_loadu_si512((const void*)(values + ix)), zero_index,
+                          nmb_unramified_lanes, nmb_ramified_lanes );
+
+  nmb_unramified += 2 * nmb_unramified_lanes;
+  nmb_ramified += nmb_ramified_lanes;
+  return ix;
+}
+
+__attribute__((target("avx512f")))
+static inline
+__m512i
+reduce_barrett_avx512(
+    __m512i t,
+    __m512i prime,
+    __m512i multiplier
+    )
+{
+  __m512i quotients_even = _mm512_srli_epi64(_mm512_mul_epu32(t, multiplier), 32);
+  __m512i quotients_odd = _mm512_mul_epu32(_mm512_srli_epi64(t, 32), multiplier);
+  __m512i quotients = _mm512_mask_blend_epi32(0xAAAA, quotients_even, quotients_odd);
+
+  __m512i remainders = _mm512_sub_epi32(t, _mm512_mullo_epi32(quotients, prime));
+  return _mm512_min_epu32(remainders, _mm512_sub_epi32(remainders, prime));
+}
+
+__attribute__((target("avx512f")))
+static
+unsigned int
+evaluate_prime_field_avx512(
+    const vector<unsigned int> & poly_coeffs,
+    unsigned int prime,
+    const uint32_t * quadratic_residues,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  const __m512i primes = _mm512_set1_epi32(prime);
+  const __m512i multiplier = _mm512_set1_epi32((uint32_t)((1ull << 32) / prime));
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bit_index_mask = _mm512_set1_epi32(31);
+
+  __m512i nmbs_unramified = _mm512_setzero_si512();
+  __m512i nmbs_ramified = _mm512_setzero_si512();
+
+  unsigned int x = 1;
+  for ( ; x + 16 <= prime; x += 16 ) {
+    __m512i xs = _mm512_add_epi32( _mm512_set1_epi32(x),
+                                   _mm512_setr_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15) );
+
+    __m512i f = _mm512_set1_epi32(poly_coeffs.back());
+    for ( size_t dx = poly_coeffs.size() - 1; dx-- > 0; )
+      f = reduce_barrett_avx512( _mm512_add_epi32(_mm512_mullo_epi32(f, xs), _mm512_set1_epi32(poly_coeffs[dx])),
+                                 primes, multiplier );
+
+    __m512i words = _mm512_i32gather_epi32(_mm512_srli_epi32(f, 5), (const int*)quadratic_residues, 4);
+    __m512i is_square = _mm512_and_si512(_mm512_srlv_epi32(words, _mm512_and_si512(f, bit_index_mask)), one);
+    nmbs_unramified = _mm512_add_epi32(nmbs_unramified, is_square);
+    nmbs_ramified = _mm512_mask_add_epi32( nmbs_ramified, _mm512_cmpeq_epi32_mask(f, _mm512_setzero_si512()),
+                                           nmbs_ramified, one );
+  }
+
+  nmb_unramified += 2 * _mm512_reduce_add_epi32(nmbs_unramified);
+  nmb_ramified += _mm512_reduce_add_epi32(nmbs_ramified);
+  return x;
+}
+
+#endif // HYCU_EVALUATION_X86
+
+
+unsigned int
+evaluate_even_odd_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return evaluate_even_odd_avx512( poly_coeff_exponents, prime_power_pred,
+                                     exponent_reduction_table.data(), incrementation_table.data(),
+                                     begin, end, nmb_unramified, nmb_ramified );
+  if ( simd == EvaluationSIMDAVX2 )
+    return evaluate_even_odd_avx2( poly_coeff_exponents, prime_power_pred,
+                                   exponent_reduction_table.data(), incrementation_table.data(),
+                                   begin, end, nmb_unramified, nmb_ramified );
+#endif
+  return begin;
+}
+
+unsigned int
+evaluate_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    const vector<int32_t> & xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return evaluate_avx512( poly_coeff_exponents, prime_power_pred,
+                            exponent_reduction_table.data(), incrementation_table.data(),
+                            xs, begin, end, nmb_unramified, nmb_ramified );
+  if ( simd == EvaluationSIMDAVX2 )
+    return evaluate_avx2( poly_coeff_exponents, prime_power_pred,
+                          exponent_reduction_table.data(), incrementation_table.data(),
+                          xs, begin, end, nmb_unramified, nmb_ramified );
+#endif
+  return begin;
+}
+
+unsigned int
+evaluate_prime_field_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeffs,
+    unsigned int prime,
+    const vector<uint32_t> & quadratic_residues,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return evaluate_prime_field_avx512( poly_coeffs, prime, quadratic_residues.data(),
+                                        nmb_unramified, nmb_ramified );
+  if ( simd == EvaluationSIMDAVX2 )
+    return evaluate_prime_field_avx2( poly_coeffs, prime, quadratic_residues.data(),
+                                      nmb_unramified, nmb_ramified );
+#endif
+  return 1;
+}
+
+void
+evaluate_lanes_simd(
+    EvaluationSIMD simd,
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int tail_size,
+    const unsigned int * coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    unsigned int * nmbs_unramified,
+    unsigned int * nmbs_ramified
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 ) {
+    evaluate_lanes_avx512( nmb_xs, prefix_values, xpws, tail_size, coeff_exponents, prime_power_pred,
+                           exponent_reduction_table.data(), incrementation_table.data(),
+                           nmbs_unramified, nmbs_ramified );
+    return;
+  }
+  if ( simd == EvaluationSIMDAVX2 ) {
+    evaluate_lanes_avx2( nmb_xs, prefix_values, xpws, tail_size, coeff_exponents, prime_power_pred,
+                         exponent_reduction_table.data(), incrementation_table.data(),
+                         nmbs_unramified, nmbs_ramified );
+    return;
+  }
+#endif
+  cerr << "evaluate_lanes_simd: instruction set without lanes: " << simd << endl;
+  throw;
+}
+
+
+unsigned int
+evaluate_values_simd(
+    EvaluationSIMD simd,
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const vector<size_t> & tail_ixs,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return evaluate_values_avx512( constant_exponent, prefix_values, poly_coeff_exponents, tail_ixs,
+                                   xs, begin, end, values, prime_power_pred,
+                                   exponent_reduction_table.data(), incrementation_table.data() );
+  if ( simd == EvaluationSIMDAVX2 )
+    return evaluate_values_avx2( constant_exponent, prefix_values, poly_coeff_exponents, tail_ixs,
+                                 xs, begin, end, values, prime_power_pred,
+                                 exponent_reduction_table.data(), incrementation_table.data() );
+#endif
+  return begin;
+}
+
+unsigned int
+add_monomial_simd(
+    EvaluationSIMD simd,
+    unsigned int term_exponent,
+    unsigned int k_reduced,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return add_monomial_avx512( term_exponent, k_reduced, values, prime_power_pred,
+                                exponent_reduction_table.data(), incrementation_table.data() );
+  if ( simd == EvaluationSIMDAVX2 )
+    return add_monomial_avx2( term_exponent, k_reduced, values, prime_power_pred,
+                              exponent_reduction_table.data(), incrementation_table.data() );
+#endif
+  return 0;
+}
+
+unsigned int
+add_term_simd(
+    EvaluationSIMD simd,
+    unsigned int term_exponent,
+    const unsigned int * xpws,
+    unsigned int nmb_xs,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return add_term_avx512( term_exponent, xpws, nmb_xs, values, prime_power_pred,
+                            exponent_reduction_table.data(), incrementation_table.data() );
+  if ( simd == EvaluationSIMDAVX2 )
+    return add_term_avx2( term_exponent, xpws, nmb_xs, values, prime_power_pred,
+                          exponent_reduction_table.data(), incrementation_table.data() );
+#endif
+  return 0;
+}
+
+unsigned int
+count_values_simd(
+    EvaluationSIMD simd,
+    const unsigned int * values,
+    unsigned int nmb_xs,
+    unsigned int prime_power_pred,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+#ifdef HYCU_EVALUATION_X86
+  if ( simd == EvaluationSIMDAVX512 )
+    return count_values_avx512(values, nmb_xs, prime_power_pred, nmb_unramified, nmb_ramified);
+  if ( simd == EvaluationSIMDAVX2 )
+    return count_values_avx2(values, nmb_xs, prime_power_pred, nmb_unramified, nmb_ramified);
+#endif
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#ifndef _H_EVALUATION_SIMD
+#define _H_EVALUATION_SIMD
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "logarithm_table.hh"
+
+
+using std::size_t;
+using std::vector;
+
+
+// the instruction sets for vectorized evaluation of polynomials
+enum EvaluationSIMD
+{
+  EvaluationSIMDScalar,
+  EvaluationSIMDAVX2,
+  EvaluationSIMDAVX512
+};
+
+// the instruction set that is used, which by default is the best one
+// supported by the cpu
+EvaluationSIMD evaluation_simd();
+// restrict vectorized evaluation to a supported instruction set
+void set_evaluation_simd(EvaluationSIMD simd);
+// the number of 32 bit lanes of the instruction set
+unsigned int evaluation_simd_width(EvaluationSIMD simd);
+
+
+// All functions take polynomials and tables as Curve::count_cpu. They
+// process as many x as fit into full vectors, add the numbers of unramified
+// and ramified points, and return the first x that was not processed.
+
+// evaluate at x = a^i and -x for begin <= i < end <= (q-1)/2
+unsigned int
+evaluate_even_odd_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// evaluate at x = a^i for i = xs[ix] with begin <= ix < end
+unsigned int
+evaluate_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    const vector<int32_t> & xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// Evaluate at x = 1, 2, ... a polynomial whose coefficients are residues
+// modulo a prime p < 2^16, by Horner's scheme with Barrett reduction. Bit r
+// of the bitmap quadratic_residues is set if r is a nonzero square. Return
+// the first x that was not processed.
+unsigned int
+evaluate_prime_field_simd(
+    EvaluationSIMD simd,
+    const vector<unsigned int> & poly_coeffs,
+    unsigned int prime,
+    const vector<uint32_t> & quadratic_residues,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// Evaluate as many curves as there are lanes, one in each lane, at nmb_xs
+// values x. The values of the part of the polynomials that is common to all
+// curves are given by prefix_values, and the exponents of the powers of the
+// x that belong to the other terms by xpws, with tail_size entries for each x.
+// The coefficient exponents are given as structure of arrays: The constant
+// coefficient of all curves comes first, and then the other ones in the order
+// of xpws. The numbers of points for each curve are added to nmbs_unramified
+// and nmbs_ramified.
+void
+evaluate_lanes_simd(
+    EvaluationSIMD simd,
+    unsigned int nmb_xs,
+    const unsigned int * prefix_values,
+    const unsigned int * xpws,
+    unsigned int tail_size,
+    const unsigned int * coeff_exponents,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table,
+    unsigned int * nmbs_unramified,
+    unsigned int * nmbs_ramified
+    );
+
+
+// The following functions serve CurveBlock, which keeps the exponents of the
+// values f(x) for all x of a block. As the ones above, they process as many
+// x as fit into full vectors and return the first index that was not processed.
+
+// Store in values[ix] the exponent of c + p(x) + sum_k f_k x^k at x = a^j
+// for j = xs[ix] with begin <= ix < end, or j = ix if xs is null. The values
+// of p are given by prefix_values[j], and the sum runs over the indices k of
+// tail_ixs with coefficient exponents f_k = poly_coeff_exponents[k]. The
+// exponent of c is constant_exponent.
+unsigned int
+evaluate_values_simd(
+    EvaluationSIMD simd,
+    unsigned int constant_exponent,
+    const unsigned int * prefix_values,
+    const vector<unsigned int> & poly_coeff_exponents,
+    const vector<size_t> & tail_ixs,
+    const int32_t * xs,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    );
+
+// add a^e x^k to values[j] at x = a^j for all j < q-1, where k_reduced is k
+// modulo q-1 and e = term_exponent refers to a nonzero coefficient
+unsigned int
+add_monomial_simd(
+    EvaluationSIMD simd,
+    unsigned int term_exponent,
+    unsigned int k_reduced,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    );
+
+// add a^e x^k to values[ix] for ix < nmb_xs, where the exponents of x^k are
+// given by xpws and e = term_exponent refers to a nonzero coefficient
+unsigned int
+add_term_simd(
+    EvaluationSIMD simd,
+    unsigned int term_exponent,
+    const unsigned int * xpws,
+    unsigned int nmb_xs,
+    unsigned int * values,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    );
+
+// add the numbers of points above x for the values[ix] with ix < nmb_xs
+unsigned int
+count_values_simd(
+    EvaluationSIMD simd,
+    const unsigned int * values,
+    unsigned int nmb_xs,
+    unsigned int prime_power_pred,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+#endif
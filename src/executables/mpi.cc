@@ -28,8 +28,10 @@
 
 #include "config/config_node.hh"
 #include "curve_iterator.hh"
+#include "factorization_pattern_iterator.hh"
 #include "fq_element_table.hh"
 #include "store/store_factory.hh"
+#include "table_registry.hh"
 #include "worker_pool/mpi.hh"
 #include "worker_pool/mpi_worker.hh"
 
@@ -150,10 +152,20 @@ main(
 
     worker_pool.update_config(node);
 
-    FqElementTable enumeration_table(node.prime, node.prime_exponent);
-    CurveIterator iter(enumeration_table, node.genus, node.with_marked_point, node.package_size);
-    for (; !iter.is_end(); iter.step() )
-      worker_pool.assign(iter.as_block());
+    auto enumeration_table = TableRegistry::fq_element_table(node.prime, node.prime_exponent);
+    if ( node.factorization_patterns ) {
+      FactorizationPatternIterator iter( enumeration_table, node.genus, node.with_marked_point,
+                                         node.package_size, node.ramification_types );
+      for (; !iter.is_end(); iter.step() )
+        worker_pool.assign(iter.as_block());
+    }
+    else {
+      CurveIterator iter( *enumeration_table, node.genus, node.with_marked_point, node.package_size,
+                          node.projective_normalization ? CurveIteratorNormalizationProjective
+                                                        : CurveIteratorNormalizationAffine );
+      for (; !iter.is_end(); iter.step() )
+        worker_pool.assign(iter.as_block());
+    }
   }
 
   return 0;
@@ -58,6 +58,7 @@ main(
 #ifdef WITH_OPENCL
     ( "opencl", "use OpenCL" )
 #endif
+    ( "primefield", "use residues instead of exponents over the prime field" )
     ( "naivenmod", "use naive nmod implementation" )
     ( "naivezech", "use naive zech implementation" );
 
@@ -105,7 +106,8 @@ main(
   }
 
   {
-    int nmb_implementations = options_map.count("naivenmod") +  options_map.count("naivezech");
+    int nmb_implementations = options_map.count("primefield") + options_map.count("naivenmod")
+                              + options_map.count("naivezech");
 #ifdef WITH_OPENCL
       nmb_implementations += options_map.count("opencl");
 #endif
@@ -116,7 +118,9 @@ main(
   }
 
   SingleCurveCountImplementation count_implementation;
-  if ( (bool)options_map.count("naivenmod") )
+  if ( (bool)options_map.count("primefield") )
+    count_implementation = SingleCurveCountImplementationPrimeField;
+  else if ( (bool)options_map.count("naivenmod") )
     count_implementation = SingleCurveCountImplementationNaiveNMod;
   else if ( (bool)options_map.count("naivezech") )
     count_implementation = SingleCurveCountImplementationNaiveZech;
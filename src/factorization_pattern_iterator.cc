@@ -0,0 +1,574 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+#include "factorization_pattern_iterator.hh"
+
+
+using namespace std;
+
+
+// all partitions of n into parts of size at most max_part in descending order
+static
+void
+descending_partitions(
+    unsigned int n,
+    unsigned int max_part,
+    vector<unsigned int> & partition,
+    vector<vector<unsigned int>> & partitions
+    )
+{
+  if ( n == 0 ) {
+    partitions.push_back(partition);
+    return;
+  }
+
+  for ( unsigned int part = min(n, max_part); part >= 1; --part ) {
+    partition.push_back(part);
+    descending_partitions(n - part, part, partition, partitions);
+    partition.pop_back();
+  }
+}
+
+// q^d, which must fit into an unsigned int
+static
+unsigned long
+checked_power(
+    unsigned int prime_power,
+    unsigned int degree
+    )
+{
+  unsigned long power = 1;
+  for ( unsigned int dx = 0; dx < degree; ++dx ) {
+    power *= prime_power;
+    if ( power > UINT_MAX ) {
+      cerr << "FactorizationPatternIterator: "
+           << "too many monic polynomials of degree " << degree << endl;
+      throw;
+    }
+  }
+  return power;
+}
+
+// the number of monic irreducible polynomials of given degree, which is
+// sum_{e | d} mu(e) q^{d/e} / d
+static
+unsigned int
+nmb_irreducible_polynomials(
+    unsigned int prime_power,
+    unsigned int degree
+    )
+{
+  long nmb = 0;
+  for ( unsigned int e = 1; e <= degree; ++e ) {
+    if ( degree % e != 0 )
+      continue;
+
+    int moebius = 1;
+    unsigned int m = e;
+    for ( unsigned int p = 2; p <= m; ++p )
+      if ( m % p == 0 ) {
+        m /= p;
+        if ( m % p == 0 ) {
+          moebius = 0;
+          break;
+        }
+        moebius = -moebius;
+      }
+
+    nmb += moebius * (long)checked_power(prime_power, degree / e);
+  }
+
+  return nmb / degree;
+}
+
+
+FactorizationPatternIterator::
+FactorizationPatternIterator(
+    shared_ptr<FqElementTable> table,
+    unsigned int genus,
+    bool with_marked_point,
+    unsigned int package_size,
+    const set<vector<unsigned int>> & ramification_types
+    ) :
+  table ( table ),
+  package_size ( package_size ),
+  pattern_ix ( 0 )
+{
+  if ( table->prime == 2 ) {
+    cerr << "FactorizationPatternIterator: "
+         << "implemented only if prime is odd" << endl;
+    throw;
+  }
+
+  if ( genus == 0 ) {
+    cerr << "FactorizationPatternIterator: "
+         << "implemented only if genus is positive" << endl;
+    throw;
+  }
+
+  unsigned int prime_power = this->table->prime_power;
+  unsigned int max_tabulated_degree = 0;
+
+  unsigned int max_degree = with_marked_point ? 2*genus + 1 : 2*genus + 2;
+  for ( unsigned int degree = 2*genus + 1; degree <= max_degree; ++degree ) {
+    vector<unsigned int> partition;
+    vector<vector<unsigned int>> partitions;
+    descending_partitions(degree, degree, partition, partitions);
+
+    for ( auto & factor_degrees : partitions ) {
+      Pattern pattern;
+
+      // the point at infinity is ramified if the degree is odd
+      pattern.ramification_type = vector<unsigned int>(factor_degrees.rbegin(), factor_degrees.rend());
+      if ( degree % 2 == 1 )
+        pattern.ramification_type.insert(pattern.ramification_type.begin(), 1);
+
+      if ( !ramification_types.empty()
+           && ramification_types.find(pattern.ramification_type) == ramification_types.end() )
+        continue;
+
+      // If the degree is not divisible by p, the representative of an orbit
+      // has vanishing next to leading coefficient, which is the sum of those
+      // of the factors.
+      pattern.searches_first_factor = factor_degrees.size() == 1 || factor_degrees[0] > factor_degrees[1];
+      pattern.fixes_first_factor_trace = pattern.searches_first_factor && degree % this->table->prime != 0;
+
+      bool is_realizable = true;
+      for ( size_t ix = 0; ix < factor_degrees.size(); ++ix ) {
+        if ( ix == 0 && pattern.searches_first_factor ) {
+          pattern.nmbs_factors.push_back(
+              checked_power( prime_power,
+                             factor_degrees[0] - (pattern.fixes_first_factor_trace ? 1 : 0) ));
+          continue;
+        }
+
+        pattern.nmbs_factors.push_back(nmb_irreducible_polynomials(prime_power, factor_degrees[ix]));
+        max_tabulated_degree = max(max_tabulated_degree, factor_degrees[ix]);
+
+        // factors of the same degree are distinct
+        size_t nmb_equal = 1;
+        while ( nmb_equal <= ix && factor_degrees[ix - nmb_equal] == factor_degrees[ix] )
+          ++nmb_equal;
+        if ( nmb_equal > pattern.nmbs_factors.back() )
+          is_realizable = false;
+      }
+
+      if ( is_realizable ) {
+        pattern.factor_degrees = move(factor_degrees);
+        this->patterns.push_back(move(pattern));
+      }
+    }
+  }
+
+  this->irreducibles.resize(max_tabulated_degree + 1);
+
+
+  if ( !this->patterns.empty() ) {
+    this->first_block();
+    if ( !this->is_block_realizable() )
+      this->step();
+  }
+}
+
+FactorizationPatternIterator::
+~FactorizationPatternIterator()
+{
+  for ( auto & polys : this->irreducibles )
+    for ( auto & poly : polys )
+      fq_nmod_poly_clear(&poly, this->table->fq_ctx);
+}
+
+FactorizationPatternIterator const&
+FactorizationPatternIterator::
+step()
+{
+  if ( this->is_end() )
+    return *this;
+
+  bool has_block = this->next_block();
+  while ( true ) {
+    if ( !has_block ) {
+      if ( ++this->pattern_ix == this->patterns.size() ) {
+        this->block.clear();
+        break;
+      }
+      this->first_block();
+    }
+
+    if ( this->is_block_realizable() )
+      break;
+    has_block = this->next_block();
+  }
+
+  return *this;
+}
+
+void
+FactorizationPatternIterator::
+first_block()
+{
+  const auto & nmbs_factors = this->patterns[this->pattern_ix].nmbs_factors;
+
+  unsigned long size = 1;
+  for ( this->nmb_complete_factors = 0;
+        this->nmb_complete_factors < nmbs_factors.size()
+          && size * nmbs_factors[this->nmb_complete_factors] <= this->package_size;
+        ++this->nmb_complete_factors )
+    size *= nmbs_factors[this->nmb_complete_factors];
+  this->block_chunk_size = max(1ul, this->package_size / size);
+
+  this->block.clear();
+  this->block.emplace_back(this->pattern_ix, this->pattern_ix + 1);
+  for ( size_t ix = 0; ix < nmbs_factors.size(); ++ix )
+    if ( ix < this->nmb_complete_factors )
+      this->block.emplace_back(0, nmbs_factors[ix]);
+    else if ( ix == this->nmb_complete_factors )
+      this->block.emplace_back(0, min(this->block_chunk_size, nmbs_factors[ix]));
+    else
+      this->block.emplace_back(0, 1);
+}
+
+bool
+FactorizationPatternIterator::
+next_block()
+{
+  const auto & nmbs_factors = this->patterns[this->pattern_ix].nmbs_factors;
+
+  for ( size_t ix = this->nmb_complete_factors; ix < nmbs_factors.size(); ++ix ) {
+    unsigned int step_size = ix == this->nmb_complete_factors ? this->block_chunk_size : 1;
+    unsigned int lbd = get<0>(this->block[ix+1]) + step_size;
+    if ( lbd < nmbs_factors[ix] ) {
+      this->block[ix+1] = make_tuple(lbd, min(lbd + step_size, nmbs_factors[ix]));
+      return true;
+    }
+    this->block[ix+1] = make_tuple(0u, min(step_size, nmbs_factors[ix]));
+  }
+
+  return false;
+}
+
+bool
+FactorizationPatternIterator::
+is_block_realizable()
+  const
+{
+  // factors of the same degree have ascending indices
+  const auto & factor_degrees = this->patterns[this->pattern_ix].factor_degrees;
+
+  unsigned int factor_ix = get<0>(this->block[1]);
+  for ( size_t ix = 1; ix < factor_degrees.size(); ++ix ) {
+    if ( factor_degrees[ix] == factor_degrees[ix-1] )
+      factor_ix = max(get<0>(this->block[ix+1]), factor_ix + 1);
+    else
+      factor_ix = get<0>(this->block[ix+1]);
+
+    if ( factor_ix >= get<1>(this->block[ix+1]) )
+      return false;
+  }
+
+  return true;
+}
+
+vector<Curve>
+FactorizationPatternIterator::
+curves(
+    const vuu_block & block
+    )
+  const
+{
+  const auto & fq_ctx = this->table->fq_ctx;
+  const auto & pattern = this->patterns[get<0>(block[0])];
+  const auto & factor_degrees = pattern.factor_degrees;
+  size_t nmb_factors = factor_degrees.size();
+
+  unsigned int degree = 0;
+  for ( auto factor_degree : factor_degrees )
+    degree += factor_degree;
+
+  vector<const vector<fq_nmod_poly_struct>*> factor_tables(nmb_factors, nullptr);
+  for ( size_t ix = pattern.searches_first_factor ? 1 : 0; ix < nmb_factors; ++ix )
+    factor_tables[ix] = &this->irreducible_polynomials(factor_degrees[ix]);
+
+
+  vector<Curve> curves;
+
+  fq_nmod_t trace, c;
+  fq_nmod_init(trace, fq_ctx);
+  fq_nmod_init(c, fq_ctx);
+  fq_nmod_poly_t first_factor, tail, poly;
+  fq_nmod_poly_init(first_factor, fq_ctx);
+  fq_nmod_poly_init(tail, fq_ctx);
+  fq_nmod_poly_init(poly, fq_ctx);
+
+  // we walk through the indices of all factors but the first one
+  vector<unsigned int> factor_ixs(nmb_factors);
+  for ( size_t ix = 1; ix < nmb_factors; ++ix )
+    factor_ixs[ix] = get<0>(block[ix+1]);
+
+  while ( true ) {
+    bool is_ascending = true;
+    for ( size_t ix = 2; ix < nmb_factors; ++ix )
+      if ( factor_degrees[ix] == factor_degrees[ix-1] && factor_ixs[ix] <= factor_ixs[ix-1] ) {
+        is_ascending = false;
+        break;
+      }
+
+    if ( is_ascending ) {
+      // the product of all factors but the first one and the sum of their next
+      // to leading coefficients
+      fq_nmod_poly_one(tail, fq_ctx);
+      fq_nmod_zero(trace, fq_ctx);
+      for ( size_t ix = 1; ix < nmb_factors; ++ix ) {
+        const auto & factor = (*factor_tables[ix])[factor_ixs[ix]];
+        fq_nmod_poly_mul(tail, tail, &factor, fq_ctx);
+        fq_nmod_poly_get_coeff(c, &factor, factor_degrees[ix] - 1, fq_ctx);
+        fq_nmod_add(trace, trace, c, fq_ctx);
+      }
+
+      for ( unsigned int ix = get<0>(block[1]); ix < get<1>(block[1]); ++ix ) {
+        if ( pattern.searches_first_factor ) {
+          this->monic_polynomial(first_factor, factor_degrees[0], ix);
+          if ( pattern.fixes_first_factor_trace ) {
+            fq_nmod_neg(c, trace, fq_ctx);
+            fq_nmod_poly_set_coeff(first_factor, factor_degrees[0] - 1, c, fq_ctx);
+          }
+          if ( !fq_nmod_poly_is_irreducible(first_factor, fq_ctx) )
+            continue;
+        }
+        else {
+          if ( nmb_factors > 1 && ix >= factor_ixs[1] )
+            break;
+          fq_nmod_poly_set(first_factor, &(*factor_tables[0])[ix], fq_ctx);
+
+          // representatives have vanishing next to leading coefficient if
+          // p does not divide the degree, which we test before multiplying
+          if ( degree % this->table->prime != 0 ) {
+            fq_nmod_poly_get_coeff(c, first_factor, factor_degrees[0] - 1, fq_ctx);
+            fq_nmod_add(c, c, trace, fq_ctx);
+            if ( !fq_nmod_is_zero(c, fq_ctx) )
+              continue;
+          }
+        }
+
+        fq_nmod_poly_mul(poly, first_factor, tail, fq_ctx);
+        unsigned int orbit_size = this->orbit_size(poly);
+        if ( orbit_size == 0 )
+          continue;
+
+        vector<unsigned int> poly_coeff_exponents;
+        poly_coeff_exponents.reserve(degree + 1);
+        for ( unsigned int dx = 0; dx <= degree; ++dx ) {
+          fq_nmod_poly_get_coeff(c, poly, dx, fq_ctx);
+          poly_coeff_exponents.push_back(this->table->index(c));
+        }
+        curves.emplace_back(this->table, poly_coeff_exponents, pattern.ramification_type, orbit_size);
+      }
+    }
+
+    size_t ix;
+    for ( ix = 1; ix < nmb_factors && ++factor_ixs[ix] == get<1>(block[ix+1]); ++ix )
+      factor_ixs[ix] = get<0>(block[ix+1]);
+    if ( ix >= nmb_factors )
+      break;
+  }
+
+  fq_nmod_poly_clear(poly, fq_ctx);
+  fq_nmod_poly_clear(tail, fq_ctx);
+  fq_nmod_poly_clear(first_factor, fq_ctx);
+  fq_nmod_clear(c, fq_ctx);
+  fq_nmod_clear(trace, fq_ctx);
+
+  return curves;
+}
+
+const vector<fq_nmod_poly_struct> &
+FactorizationPatternIterator::
+irreducible_polynomials(
+    unsigned int degree
+    )
+  const
+{
+  lock_guard<mutex> irreducibles_lock(this->irreducibles_mutex);
+
+  auto & polys = this->irreducibles[degree];
+  if ( polys.empty() ) {
+    const auto & fq_ctx = this->table->fq_ctx;
+    unsigned long nmb_monic = checked_power(this->table->prime_power, degree);
+
+    fq_nmod_poly_t poly;
+    fq_nmod_poly_init(poly, fq_ctx);
+    for ( unsigned long ix = 0; ix < nmb_monic; ++ix ) {
+      this->monic_polynomial(poly, degree, ix);
+      if ( fq_nmod_poly_is_irreducible(poly, fq_ctx) ) {
+        polys.emplace_back();
+        fq_nmod_poly_init(&polys.back(), fq_ctx);
+        fq_nmod_poly_set(&polys.back(), poly, fq_ctx);
+      }
+    }
+    fq_nmod_poly_clear(poly, fq_ctx);
+  }
+
+  return polys;
+}
+
+void
+FactorizationPatternIterator::
+monic_polynomial(
+    fq_nmod_poly_t poly,
+    unsigned int degree,
+    unsigned int ix
+    )
+  const
+{
+  const auto & fq_ctx = this->table->fq_ctx;
+  unsigned int prime_power = this->table->prime_power;
+
+  fq_nmod_t a;
+  fq_nmod_init(a, fq_ctx);
+
+  fq_nmod_poly_zero(poly, fq_ctx);
+  for ( unsigned int dx = 0; dx < degree; ++dx, ix /= prime_power ) {
+    this->table->element(a, ix % prime_power);
+    fq_nmod_poly_set_coeff(poly, dx, a, fq_ctx);
+  }
+  this->table->element(a, 0);
+  fq_nmod_poly_set_coeff(poly, degree, a, fq_ctx);
+
+  fq_nmod_clear(a, fq_ctx);
+}
+
+unsigned int
+FactorizationPatternIterator::
+orbit_size(
+    const fq_nmod_poly_t poly
+    )
+  const
+{
+  const auto & fq_ctx = this->table->fq_ctx;
+  unsigned int prime_power = this->table->prime_power;
+  unsigned int prime_power_pred = this->table->prime_power_pred;
+  unsigned int zero_index = this->table->zero_index();
+  unsigned int degree = fq_nmod_poly_degree(poly, fq_ctx);
+
+  fq_nmod_t c;
+  fq_nmod_init(c, fq_ctx);
+  auto coeff_exponents = [&](const fq_nmod_poly_t f, vector<unsigned int> & exponents) {
+    exponents.resize(degree + 1);
+    for ( unsigned int dx = 0; dx <= degree; ++dx ) {
+      fq_nmod_poly_get_coeff(c, f, dx, fq_ctx);
+      exponents[dx] = this->table->index(c);
+    }
+  };
+
+  vector<unsigned int> exponents;
+  coeff_exponents(poly, exponents);
+
+  // Substitutions x -> b_3 x + b_1 change the next to leading coefficient
+  // by n b_1 / b_3. If p divides n, and it vanishes, they change the one that
+  // follows by -b_1 a_{n-1} / b_3^2. Representatives are normalized so that
+  // only the remaining substitutions need to be compared.
+  bool translates = false;
+  if ( degree % this->table->prime != 0 ) {
+    if ( exponents[degree-1] != zero_index ) {
+      fq_nmod_clear(c, fq_ctx);
+      return 0;
+    }
+  }
+  else if ( exponents[degree-1] != zero_index ) {
+    if ( exponents[degree-2] != zero_index ) {
+      fq_nmod_clear(c, fq_ctx);
+      return 0;
+    }
+  }
+  else
+    translates = true;
+
+  // f -> b_3^{-n} f(b_3 x) is an isomorphism if b_3^n is a square
+  unsigned int scaling_step = degree % 2 == 0 ? 1 : 2;
+  unsigned int nmb_scalings = prime_power_pred / scaling_step;
+
+  // the representative has the least exponents of its orbit
+  unsigned int stabilizer_size = 0;
+  bool is_representative = true;
+
+  fq_nmod_poly_t shift, translate;
+  fq_nmod_poly_init(shift, fq_ctx);
+  fq_nmod_poly_init(translate, fq_ctx);
+  fq_nmod_poly_gen(shift, fq_ctx);
+  vector<unsigned int> translate_exponents;
+
+  for ( unsigned int tx = 0; tx < (translates ? prime_power : 1) && is_representative; ++tx ) {
+    if ( tx == 0 )
+      translate_exponents = exponents;
+    else {
+      this->table->element(c, tx - 1);
+      fq_nmod_poly_set_coeff(shift, 0, c, fq_ctx);
+      fq_nmod_poly_compose(translate, poly, shift, fq_ctx);
+      coeff_exponents(translate, translate_exponents);
+    }
+
+    for ( unsigned int k = 0; k < prime_power_pred; k += scaling_step ) {
+      int cmp = 0;
+      for ( unsigned int dx = 0; dx <= degree && cmp == 0; ++dx ) {
+        unsigned int e = translate_exponents[dx];
+        if ( e != zero_index )
+          e = ( e + prime_power_pred - (unsigned long)k * (degree - dx) % prime_power_pred )
+              % prime_power_pred;
+        cmp = e < exponents[dx] ? -1 : ( e > exponents[dx] ? 1 : 0 );
+      }
+
+      if ( cmp < 0 ) {
+        is_representative = false;
+        break;
+      }
+      if ( cmp == 0 )
+        ++stabilizer_size;
+    }
+  }
+
+  fq_nmod_poly_clear(translate, fq_ctx);
+  fq_nmod_poly_clear(shift, fq_ctx);
+  fq_nmod_clear(c, fq_ctx);
+
+  if ( !is_representative )
+    return 0;
+  return prime_power * nmb_scalings / stabilizer_size;
+}
+
+void
+FactorizationPatternIterator::
+multiplicity(
+    fmpz_t mult,
+    unsigned int prime_power,
+    unsigned int orbit_size
+    )
+{
+  // a representative f stands for all a g with g in its orbit and a a nonzero square
+  fmpz_set_ui(mult, prime_power - 1);
+  fmpz_fdiv_q_2exp(mult, mult, 1); // / 2
+  fmpz_mul_ui(mult, mult, orbit_size);
+}
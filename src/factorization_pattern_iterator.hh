@@ -0,0 +1,137 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#ifndef _H_FACTORIZATION_PATTERN_ITERATOR
+#define _H_FACTORIZATION_PATTERN_ITERATOR
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <flint/fmpz.h>
+#include <flint/fq_nmod_poly.h>
+
+#include "block_iterator.hh"
+#include "curve.hh"
+#include "fq_element_table.hh"
+
+
+using std::mutex;
+using std::set;
+using std::shared_ptr;
+using std::tuple;
+using std::vector;
+
+
+// Enumerate curves whose right hand side is a product of distinct monic
+// irreducible polynomials. All of them are squarefree and carry their
+// ramification type. Only one right hand side f of degree n is enumerated for
+// each orbit under f -> b_3^{-n} f(b_3 x + b_1) with b_3^n a square, all of
+// whose curves are isomorphic. Each curve stands for its orbit and the
+// multiples of it by nonzero squares; as for CurveIterator, quadratic twists
+// are not enumerated separately.
+//
+// Like CurveIterator, the iterator steps through blocks, which can be handed
+// to threads and workers. The first entry of a block is the range of the
+// pattern index, and the others are ranges of the indices of the factors. The
+// factor of largest degree is found among the monic polynomials of a block if
+// no other factor has the same degree, so that irreducible polynomials are
+// tabulated only up to half the degree of the right hand side.
+class FactorizationPatternIterator
+{
+  public:
+    // if ramification types are given, only curves of these types are enumerated
+    FactorizationPatternIterator(
+      shared_ptr<FqElementTable> table,
+      unsigned int genus,
+      bool with_marked_point,
+      unsigned int package_size,
+      const set<vector<unsigned int>> & ramification_types = {}
+    );
+    ~FactorizationPatternIterator();
+
+    FactorizationPatternIterator(const FactorizationPatternIterator &) = delete;
+    FactorizationPatternIterator & operator=(const FactorizationPatternIterator &) = delete;
+
+    FactorizationPatternIterator const& step();
+    bool inline is_end() const { return this->pattern_ix == this->patterns.size(); };
+
+    vuu_block inline as_block() const { return this->block; };
+    // the curves of the current block
+    vector<Curve> inline as_curves() const { return this->curves(this->block); };
+    // the curves of a block of an iterator with the same parameters; this is
+    // safe to call from several threads
+    vector<Curve> curves(const vuu_block & block) const;
+
+    // the number of right hand sides that a curve stands for, given the
+    // size of its orbit, which is compatible with CurveIterator::multiplicity
+    static void multiplicity(fmpz_t mult, unsigned int prime_power, unsigned int orbit_size);
+
+  private:
+    shared_ptr<FqElementTable> table;
+    unsigned int package_size;
+
+    struct Pattern
+    {
+      // the degrees of the factors in descending order, and the ramification
+      // type that they yield
+      vector<unsigned int> factor_degrees;
+      vector<unsigned int> ramification_type;
+      // whether the first factor is searched among monic polynomials instead
+      // of being tabulated, and whether its next to leading coefficient is
+      // then determined by the others
+      bool searches_first_factor;
+      bool fixes_first_factor_trace;
+      // the number of indices of each factor
+      vector<unsigned int> nmbs_factors;
+    };
+    vector<Pattern> patterns;
+    size_t pattern_ix;
+
+    // blocks of the current pattern comprise all indices of the first
+    // nmb_complete_factors factors and a range of block_chunk_size indices of
+    // the next one
+    size_t nmb_complete_factors;
+    unsigned int block_chunk_size;
+    vuu_block block;
+
+    // monic irreducible polynomials by their degree, which are tabulated on
+    // first use
+    mutable vector<vector<fq_nmod_poly_struct>> irreducibles;
+    mutable mutex irreducibles_mutex;
+    const vector<fq_nmod_poly_struct> & irreducible_polynomials(unsigned int degree) const;
+
+    void first_block();
+    bool next_block();
+    bool is_block_realizable() const;
+
+    // set poly to the monic polynomial of given degree whose lower coefficients
+    // are given by the digits of ix in base q
+    void monic_polynomial(fq_nmod_poly_t poly, unsigned int degree, unsigned int ix) const;
+    // the size of the orbit of a monic right hand side if it is the
+    // representative of its orbit, and zero otherwise
+    unsigned int orbit_size(const fq_nmod_poly_t poly) const;
+};
+
+#endif
@@ -22,8 +22,11 @@
 
 
 #include <cmath>
+#include <flint/nmod_poly.h>
 
 #include "fq_element_table.hh"
+#include "reduction_table.hh"
+#include "table_cache.hh"
 
 
 using namespace std;
@@ -45,75 +48,69 @@ FqElementTable(
   fq_nmod_ctx_init(this->fq_ctx, prime_fmpz, prime_exponent, ((string)"T").c_str());
   fmpz_clear(prime_fmpz);
 
-  fq_nmod_t gen;
-  fq_nmod_init(gen, this->fq_ctx);
-  fq_nmod_gen(gen, this->fq_ctx);
-
-  fq_nmod_t a;
-  fq_nmod_init(a, this->fq_ctx);
-  fq_nmod_one(a, this->fq_ctx);
-
-  flint_rand_t state;
-  flint_randinit(state);
-
-
-  this->fq_elements.reserve(this->prime_power);
-
-  for ( bool is_gen = false; !is_gen; fq_nmod_randtest(gen, state, this->fq_ctx)) {
-    is_gen = true;
-
-    this->fq_elements.clear();
-
-    auto b = new fq_nmod_struct;
-    fq_nmod_init(b, this->fq_ctx);
-    fq_nmod_set(b, a, this->fq_ctx);
-    fq_nmod_reduce(b, this->fq_ctx);
-    this->fq_elements.push_back(b);
-
-    fq_nmod_mul(a, a, gen, this->fq_ctx);
-
-    for (size_t ix=1; ix<this->prime_power_pred; ++ix) {
-      if ( fq_nmod_equal(a, this->fq_elements.front(), this->fq_ctx) ) {
-        is_gen = false;
-        for ( auto fq : this->fq_elements ) {
-          fq_nmod_clear(fq, this->fq_ctx);
-          delete fq;
-        }
-        break;
-      }
-      auto b = new fq_nmod_struct;
-      fq_nmod_init(b, this->fq_ctx);
-      fq_nmod_set(b, a, this->fq_ctx);
-      fq_nmod_reduce(b, this->fq_ctx);
-
-      this->fq_elements.push_back(b);
-
-      fq_nmod_mul(a, a, gen, this->fq_ctx);
+  // the logarithm table determines the elements at all indices: the element
+  // with label l, i.e. with coefficients l read as digits in base p, has
+  // index logarithms[l]
+  auto logarithms = ReductionTable::logarithm_table(prime, prime_exponent);
+
+  this->labels = TableCache::load_or_compute<uint32_t>( this->fq_ctx, "labels", this->prime_power,
+      [this, &logarithms]() {
+        vector<uint32_t> labels(this->prime_power);
+        for ( unsigned int label = 0; label < this->prime_power; ++label )
+          labels[(*logarithms)[label]] = label;
+        return make_shared<const MappedTable<uint32_t>>(move(labels));
+      } );
+
+  this->element_indices = logarithms;
+
+  if ( this->is_prime_field() && prime < (1u << 16) ) {
+    this->quadratic_residues.resize((prime + 31) / 32, 0);
+    for ( unsigned int ex = 0; ex < this->prime_power_pred; ex += 2 ) {
+      unsigned int r = this->at_nmod(ex);
+      this->quadratic_residues[r / 32] |= 1u << (r % 32);
     }
   }
+}
 
-  { // the case of b == 0
-    auto b = new fq_nmod_struct;
-    fq_nmod_init(b, this->fq_ctx);
-    fq_nmod_zero(b, this->fq_ctx);
-    fq_nmod_reduce(b, this->fq_ctx);
-    this->fq_elements.push_back(b);
-  }
+FqElementTable::
+~FqElementTable()
+{
+  fq_nmod_ctx_clear(this->fq_ctx);
+}
 
-  flint_randclear(state);
-  fq_nmod_clear(gen, this->fq_ctx);
-  fq_nmod_clear(a, this->fq_ctx);
+void
+FqElementTable::
+element(
+    fq_nmod_t a,
+    unsigned int ix
+    ) const
+{
+  fq_nmod_zero(a, this->fq_ctx);
+  unsigned int digits = (*this->labels)[ix];
+  for ( unsigned int dx = 0; digits != 0; ++dx, digits /= this->prime )
+    if ( digits % this->prime != 0 )
+      nmod_poly_set_coeff_ui(a, dx, digits % this->prime);
 }
 
+unsigned int
 FqElementTable::
-~FqElementTable()
+index(
+    const fq_nmod_struct* a
+    ) const
 {
-  for ( auto fq : this->fq_elements ) {
-    fq_nmod_clear(fq, this->fq_ctx);
-    delete fq;
-  }
+  return (*this->element_indices)[this->element_digits(a)];
+}
 
-  fq_nmod_ctx_clear(this->fq_ctx);
+unsigned int
+FqElementTable::
+element_digits(
+    const fq_nmod_struct* a
+    ) const
+{
+  unsigned int digits = 0;
+  for ( int ix = this->prime_exponent - 1; ix >= 0; --ix )
+    digits = digits * this->prime + nmod_poly_get_coeff_ui(a, ix);
+  return digits;
 }
 
 
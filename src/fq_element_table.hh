@@ -24,12 +24,17 @@
 #ifndef _H_FQ_ELEMENT_TABLE
 #define _H_FQ_ELEMENT_TABLE
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <tuple>
 #include <vector>
 #include <flint/fq_nmod.h>
 
+#include "logarithm_table.hh"
 
+
+using std::shared_ptr;
 using std::tuple;
 using std::make_tuple;
 using std::vector;
@@ -49,10 +54,12 @@ class FqElementTable
 
     inline unsigned int at_nmod(int ix) const
     {
-      return nmod_poly_get_coeff_ui(this->fq_elements.at(ix), 0);
+      return (*this->labels)[ix] % this->prime;
     };
-    inline const fq_nmod_struct* at(unsigned int ix) const { return this->fq_elements[ix]; };
-    inline const fq_nmod_struct* operator[](unsigned int ix) const { return this->fq_elements[ix]; };
+    // set a, which must be initialized, to the element at an index
+    void element(fq_nmod_t a, unsigned int ix) const;
+    // the index of a reduced element
+    unsigned int index(const fq_nmod_struct* a) const;
 
     unsigned int inline zero_index() const { return this->prime_power_pred; };
     inline tuple<unsigned int,unsigned int> block_non_zero() const { return make_tuple(0, (int)this->prime_power_pred); };
@@ -61,8 +68,19 @@ class FqElementTable
 
     unsigned int inline reduce_index(unsigned int ix) const { return ix % this->prime_power_pred; };
 
+    // the memory held by the table in bytes
+    inline size_t memory_size() const
+    {
+      return   this->labels->size() * sizeof(uint32_t)
+             + this->element_indices->size() * sizeof(int32_t)
+             + this->quadratic_residues.size() * sizeof(uint32_t);
+    };
+
     friend Curve;
+    friend class CountAutotuner;
+    friend class CurveBlock;
     friend class CurveIterator;
+    friend class FactorizationPatternIterator;
     friend ostream& operator<<(ostream & stream, const Curve & curve);
 
   protected:
@@ -73,7 +91,18 @@ class FqElementTable
 
   private:
     fq_nmod_ctx_t fq_ctx;
-    vector<fq_nmod_struct*> fq_elements;
+    // the labels of the elements by index, i.e. their coefficients read as
+    // digits in base p, which is the inverse of element_indices; mapped from
+    // the table cache if it is enabled
+    shared_ptr<const MappedTable<uint32_t>> labels;
+    // indices of the elements by their coefficients read as digits in base p,
+    // which are mapped from the table cache if it is enabled
+    shared_ptr<const LogarithmTable> element_indices;
+    // for prime fields with p < 2^16, one bit for each residue, which is set
+    // for nonzero squares
+    vector<uint32_t> quadratic_residues;
+
+    unsigned int element_digits(const fq_nmod_struct* a) const;
 };
 
 #endif
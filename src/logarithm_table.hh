@@ -0,0 +1,75 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#ifndef _H_LOGARITHM_TABLE
+#define _H_LOGARITHM_TABLE
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+using std::shared_ptr;
+using std::vector;
+
+
+// Entries of a table of a finite field that are either held by the table or
+// kept by storage that is released together with it, such as a read only
+// mapping by TableCache, through which processes on one node share them.
+template<typename T>
+class MappedTable
+{
+  public:
+    MappedTable(vector<T> && entries) :
+      owned( std::move(entries) ),
+      _data( owned.data() ),
+      _size( owned.size() )
+      {};
+    MappedTable(shared_ptr<const void> storage, const T * data, size_t size) :
+      storage( storage ),
+      _data( data ),
+      _size( size )
+      {};
+
+    // the entries of owned tables must not move
+    MappedTable(const MappedTable &) = delete;
+    MappedTable & operator=(const MappedTable &) = delete;
+
+    inline const T & operator[](size_t ix) const { return this->_data[ix]; };
+    inline const T * data() const { return this->_data; };
+    inline size_t size() const { return this->_size; };
+
+  private:
+    vector<T> owned;
+    shared_ptr<const void> storage;
+
+    const T * _data;
+    size_t _size;
+};
+
+// The exponents of the elements of F_q with respect to a fixed generator,
+// labelled by their coefficients c_i with respect to the polynomial basis as
+// sum_i c_i p^i, where zero has exponent q-1.
+typedef MappedTable<int32_t> LogarithmTable;
+
+#endif
@@ -22,6 +22,52 @@
 
 AS_STRING(
 
+int
+add_exponents(
+  int f,
+  int g,
+  const int prime_power_pred,
+  global const int * restrict exponent_reduction_table,
+  global const int * restrict incrementation_table
+  )
+{
+  if (f == prime_power_pred) // i.e. f = 0
+    return g;
+  if (g == prime_power_pred) // i.e. g = 0
+    return f;
+
+  if (g <= f) {
+    int tmp = f;
+    f = g;
+    g = tmp;
+  }
+  int inc = incrementation_table[g-f];
+  if (inc == prime_power_pred)
+    return prime_power_pred;
+  return exponent_reduction_table[f + inc];
+}
+
+void
+record_point(
+  int x,
+  int f,
+  const int prime_power_pred,
+  global int * restrict nmbs_unramified,
+  global int * restrict nmbs_ramified
+  )
+{
+  if (f == prime_power_pred) {
+    nmbs_unramified[x] = 0;
+    nmbs_ramified[x] = 1;
+  } else if (f & 1) {
+    nmbs_unramified[x] = 0;
+    nmbs_ramified[x] = 0;
+  } else {
+    nmbs_unramified[x] = 2;
+    nmbs_ramified[x] = 0;
+  }
+}
+
 void
 kernel
 evaluate(
@@ -37,48 +83,36 @@ evaluate(
 {
   // The variable x = a^i is represented by i < prime_power_pred.
   // The case x=0 will not occur, but any element 0 is represented by then number prime_power_pred.
+  // Each work item treats x and -x = a^(i + (q-1)/2) for i < (q-1)/2. If f = E + O is
+  // the decomposition into even and odd part, then f(-x) = E(x) - O(x).
   int x = get_global_id(0);
+  int minus_one_exponent = prime_power_pred / 2;
   
-  int f = poly_coeffs_exponents[0];
+  int f_even = poly_coeffs_exponents[0];
+  int f_odd = prime_power_pred;
   int xpw = 0;
   #pragma unroll
   for (int dx=1; dx < POLY_SIZE; ++dx) {
     xpw += x;
     xpw = exponent_reduction_table[xpw];
     if (poly_coeffs_exponents[dx] != prime_power_pred) { // i.e. coefficient is not zero
-      if (f == prime_power_pred) // i.e. f = 0
-        f = exponent_reduction_table[poly_coeffs_exponents[dx] + xpw];
-      else {
-        int tmp = exponent_reduction_table[poly_coeffs_exponents[dx] + xpw];
-        
-        int tmp2;
-        if (tmp <= f) {
-          // this can be removed by doubling the size of incrementation_table
-          // and checking at prime_power_pred + tmp - f
-          tmp2 = f;
-          f = tmp;
-          tmp = tmp2;
-        }
-        tmp2 = incrementation_table[tmp-f];
-        if (tmp2 != prime_power_pred) {
-          f = f + tmp2;
-          f = exponent_reduction_table[f];
-        } else
-          f = prime_power_pred;
-      }
+      int term = exponent_reduction_table[poly_coeffs_exponents[dx] + xpw];
+      if (dx & 1)
+        f_odd = add_exponents(f_odd, term, prime_power_pred, exponent_reduction_table, incrementation_table);
+      else
+        f_even = add_exponents(f_even, term, prime_power_pred, exponent_reduction_table, incrementation_table);
     }
   }
-  
-  if (f == prime_power_pred) {
-    nmbs_unramified[x] = 0;
-    nmbs_ramified[x] = 1;
-  } else if (f & 1) {
-    nmbs_unramified[x] = 0;
-    nmbs_ramified[x] = 0;
-  } else {
-    nmbs_unramified[x] = 2;
-    nmbs_ramified[x] = 0;
-  }
+
+  int f = add_exponents(f_even, f_odd, prime_power_pred, exponent_reduction_table, incrementation_table);
+  record_point(x, f, prime_power_pred, nmbs_unramified, nmbs_ramified);
+
+  if (f_odd != prime_power_pred)
+    f = add_exponents( f_even, exponent_reduction_table[f_odd + minus_one_exponent],
+                       prime_power_pred, exponent_reduction_table, incrementation_table );
+  else
+    f = f_even;
+  record_point(x + minus_one_exponent, f, prime_power_pred, nmbs_unramified, nmbs_ramified);
 }
 
 );
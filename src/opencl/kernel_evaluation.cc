@@ -110,8 +110,9 @@ enqueue(
   }
 
 
+  // each work item evaluates at x and -x
   status = opencl->queue->enqueueNDRangeKernel( *this->kernel_cl,
-               cl::NullRange, cl::NDRange(prime_power_pred), cl::NullRange );
+               cl::NullRange, cl::NDRange(prime_power_pred / 2), cl::NullRange );
   if ( status != CL_SUCCESS ) {
     cerr << "OpenCLKernelEvaluation::enqueue: could not enqueue kernel" << endl;
     throw;
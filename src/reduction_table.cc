@@ -21,23 +21,36 @@
 ===============================================================================*/
 
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <flint/fq_nmod.h>
 #include <flint/fmpz.h>
 #include <flint/nmod_poly.h>
 #include <flint/ulong_extras.h>
+#include <iostream>
 #include <map>
 #include <memory>
+#include <thread>
 #include <tuple>
 #include <vector>
 
+#include "evaluation_simd.hh"
 #include "opencl/interface.hh"
 #include "reduction_table.hh"
+#include "table_cache.hh"
 
 
 using namespace std;
 
 
+const unsigned int ReductionTable::min_chunk_size = 1 << 14;
+
+map<tuple<unsigned int,unsigned int>, weak_ptr<const LogarithmTable>> ReductionTable::logarithm_tables;
+mutex ReductionTable::logarithm_tables_mutex;
+
+
 ReductionTable::
 ReductionTable(
     unsigned int prime,
@@ -48,7 +61,9 @@ ReductionTable(
   prime_exponent( prime_exponent ),
   prime_power( pow(prime,prime_exponent) ),
   prime_power_pred( prime_power - 1 ),
-  opencl( move(opencl) )
+  opencl( move(opencl) ),
+  _count_variant( CountVariantTables ),
+  _block_count_implementation( CurveBlockCountImplementationCorrelation )
 {
   this->compute_tables();
 #ifdef WITH_OPENCL
@@ -69,7 +84,9 @@ ReductionTable(
   prime_exponent( prime_exponent ),
   prime_power( pow(prime,prime_exponent) ),
   prime_power_pred( prime_power - 1 ),
-  opencl( opencl )
+  opencl( opencl ),
+  _count_variant( CountVariantTables ),
+  _block_count_implementation( CurveBlockCountImplementationCorrelation )
 {
   this->compute_tables();
 #ifdef WITH_OPENCL
@@ -85,8 +102,119 @@ ReductionTable::
 compute_tables()
 {
   this->exponent_reduction_table = this->compute_exponent_reduction_table(prime_power);
-  this->incrementation_table =
-      this->compute_incrementation_table(prime, prime_exponent, prime_power);
+
+  // the derived tables are cached along with the logarithm table, which is
+  // only needed if they are missing
+  fmpz_t prime_fmpz;
+  fmpz_init_set_ui(prime_fmpz, prime);
+  fq_nmod_ctx_t ctx;
+  fq_nmod_ctx_init(ctx, prime_fmpz, prime_exponent, ((string)"T").c_str());
+  fmpz_clear(prime_fmpz);
+
+  this->incrementation_table = TableCache::load_or_compute<int32_t>(
+      ctx, "incrementations", prime_power,
+      [this]() {
+        auto logarithms = ReductionTable::logarithm_table(this->prime, this->prime_exponent);
+        return this->compute_incrementation_table(*logarithms);
+      } );
+  if ( this->prime_power <= (1u << 16) )
+    this->compact_zech_table = TableCache::load_or_compute<CompactZechEntry>(
+        ctx, "compact_zech", 2*prime_power_pred + 1,
+        [this]() { return this->compute_compact_zech_table(*this->incrementation_table); } );
+  this->small_field_kernel = ::small_field_kernel(prime, prime_exponent, *this->incrementation_table);
+  this->additive_table = TableCache::load_or_compute<int32_t>(
+      ctx, "additive", prime_power,
+      [this]() { return this->compute_additive_table(*this->incrementation_table); } );
+  this->additive_table_inverse = TableCache::load_or_compute<int32_t>(
+      ctx, "additive_inverse", prime_power,
+      [this]() { return this->compute_additive_table_inverse(*this->additive_table); } );
+
+  fq_nmod_ctx_clear(ctx);
+}
+
+size_t
+ReductionTable::
+memory_size()
+  const
+{
+  size_t size = 0;
+  if ( this->exponent_reduction_table )
+    size += this->exponent_reduction_table->size() * sizeof(int32_t);
+  for ( const auto & table : { this->incrementation_table, this->additive_table, this->additive_table_inverse } )
+    if ( table )
+      size += table->size() * sizeof(int32_t);
+  if ( this->compact_zech_table )
+    size += this->compact_zech_table->size() * sizeof(CompactZechEntry);
+  // the bitsliced evaluation holds one label for each element
+  {
+    lock_guard<mutex> bitsliced_evaluation_lock(this->bitsliced_evaluation_mutex);
+    if ( this->bitsliced_evaluation )
+      size += (size_t)this->prime_power * sizeof(uint32_t);
+  }
+  {
+    lock_guard<mutex> representatives_lock(this->frobenius_orbit_representatives_mutex);
+    for ( const auto & representatives : this->_frobenius_orbit_representatives )
+      size += representatives.second->size() * sizeof(int32_t);
+  }
+
+  return size;
+}
+
+bool
+ReductionTable::
+is_count_variant_available(
+    CountVariant variant
+    ) const
+{
+  switch ( variant ) {
+    case CountVariantTables:
+      return true;
+    case CountVariantScalarTables:
+      return evaluation_simd() != EvaluationSIMDScalar;
+    case CountVariantPrimeField:
+      return this->prime_exponent == 1 && this->prime < (1u << 16);
+    case CountVariantBitsliced:
+      return    this->prime == 3
+             && this->prime_exponent <= BitslicedEvaluation::max_prime_exponent;
+  }
+  return false;
+}
+
+void
+ReductionTable::
+set_count_variant(
+    CountVariant variant
+    )
+{
+  if ( !this->is_count_variant_available(variant) ) {
+    cerr << "ReductionTable.set_count_variant: variant not available for "
+         << this->prime << "^" << this->prime_exponent << ": " << variant << endl;
+    throw;
+  }
+
+  // the bitsliced evaluation is built when it is first selected, and kept
+  // afterwards, since other threads may still count with it
+  if ( variant == CountVariantBitsliced ) {
+    lock_guard<mutex> bitsliced_evaluation_lock(this->bitsliced_evaluation_mutex);
+    if ( !this->bitsliced_evaluation )
+      this->bitsliced_evaluation = make_shared<BitslicedEvaluation>(
+          this->prime_exponent, *ReductionTable::logarithm_table(this->prime, this->prime_exponent) );
+  }
+
+  this->_count_variant = variant;
+}
+
+void
+ReductionTable::
+set_block_count_implementation(
+    CurveBlockCountImplementation implementation
+    )
+{
+  if ( implementation == CurveBlockCountImplementationTuned ) {
+    cerr << "ReductionTable.set_block_count_implementation: implementation must be fixed" << endl;
+    throw;
+  }
+  this->_block_count_implementation = implementation;
 }
 
 shared_ptr<vector<int32_t>>
@@ -105,9 +233,90 @@ compute_exponent_reduction_table(
   return reductions;
 }
 
-shared_ptr<vector<int32_t>>
+// a is a generator of F_q^* if and only if a^((q-1)/l) != 1 for all primes l
+// that divide q-1
+static
+bool
+is_multiplicative_generator(
+    const fq_nmod_t a,
+    const n_factor_t & factors,
+    unsigned int prime_power_pred,
+    const fq_nmod_ctx_t ctx
+    )
+{
+  if ( fq_nmod_is_zero(a, ctx) )
+    return false;
+
+  fq_nmod_t b;
+  fq_nmod_init(b, ctx);
+
+  bool is_generator = true;
+  for ( int fx = 0; fx < factors.num && is_generator; ++fx ) {
+    fq_nmod_pow_ui(b, a, prime_power_pred / factors.p[fx], ctx);
+    is_generator = !fq_nmod_is_one(b, ctx);
+  }
+
+  fq_nmod_clear(b, ctx);
+  return is_generator;
+}
+
+// Walk the powers a^i with i in [begin, end) and record their exponents by
+// their labels. Multiplication by a is F_p-linear with respect to the
+// polynomial basis and is given by a matrix, whose entry (i,j) is the i-th
+// coefficient of a T^j.
+static
+void
+record_logarithms(
+    vector<int32_t> & logarithms,
+    const vector<uint64_t> & multiplication_matrix,
+    vector<uint64_t> coeffs,
+    unsigned int prime,
+    size_t begin,
+    size_t end
+    )
+{
+  size_t prime_exponent = coeffs.size();
+  vector<uint64_t> product(prime_exponent);
+
+  for ( size_t ix = begin; ix < end; ++ix ) {
+    uint64_t label = 0;
+    for ( size_t dx = prime_exponent; dx-- > 0; )
+      label = label * prime + coeffs[dx];
+    logarithms[label] = ix;
+
+    for ( size_t dx = 0; dx < prime_exponent; ++dx ) {
+      uint64_t c = 0;
+      for ( size_t ex = 0; ex < prime_exponent; ++ex )
+        c += multiplication_matrix[dx*prime_exponent + ex] * coeffs[ex];
+      product[dx] = c % prime;
+    }
+    swap(coeffs, product);
+  }
+}
+
+shared_ptr<const LogarithmTable>
 ReductionTable::
-compute_incrementation_table(
+logarithm_table(
+    unsigned int prime,
+    unsigned int prime_exponent
+    )
+{
+  // tables are built while holding the lock, so that each is built only once
+  lock_guard<mutex> logarithm_tables_lock(logarithm_tables_mutex);
+
+  auto & logarithms_weak = logarithm_tables[make_tuple(prime, prime_exponent)];
+  auto logarithms = logarithms_weak.lock();
+  if ( !logarithms ) {
+    logarithms = ReductionTable::compute_logarithm_table(prime, prime_exponent, pow(prime, prime_exponent));
+    logarithms_weak = logarithms;
+  }
+
+  return logarithms;
+}
+
+shared_ptr<const LogarithmTable>
+ReductionTable::
+compute_logarithm_table(
     unsigned int prime,
     unsigned int prime_exponent,
     unsigned int prime_power
@@ -120,6 +329,14 @@ compute_incrementation_table(
   fq_nmod_ctx_init(ctx, prime_fmpz, prime_exponent, ((string)"T").c_str());
   fmpz_clear(prime_fmpz);
 
+  auto cached_logarithms = TableCache::load<int32_t>(ctx, "logarithms", prime_power);
+  if ( cached_logarithms ) {
+    fq_nmod_ctx_clear(ctx);
+    return cached_logarithms;
+  }
+
+  unsigned int prime_power_pred = prime_power - 1;
+
   fq_nmod_t gen;
   fq_nmod_init(gen, ctx);
   // Flint, when the field is not given by Conway polynomials, does not provide a multiplicative generator
@@ -128,52 +345,193 @@ compute_incrementation_table(
   fq_nmod_t a;
   fq_nmod_init(a, ctx);
 
+  // the candidates after T are fixed by the seed of the random state, so that
+  // the generator, and hence the indices of elements, does not vary between runs
   flint_rand_t state;
   flint_randinit(state);
 
+  n_factor_t factors;
+  n_factor_init(&factors);
+  n_factor(&factors, prime_power_pred, 1);
 
-  map<int32_t,int32_t> gen_powers;
+  while ( !is_multiplicative_generator(gen, factors, prime_power_pred, ctx) )
+    fq_nmod_randtest(gen, state, ctx);
 
-  for ( bool is_gen = false; !is_gen; fq_nmod_randtest(gen, state, ctx)) {
-    is_gen = true;
 
-    gen_powers.clear();
-    gen_powers[0] = prime_power - 1; // special index for 0
+  vector<uint64_t> multiplication_matrix(prime_exponent*prime_exponent);
+  fq_nmod_one(a, ctx);
+  fq_nmod_t b;
+  fq_nmod_init(b, ctx);
+  for ( size_t ex = 0; ex < prime_exponent; ++ex ) {
+    fq_nmod_mul(b, a, gen, ctx);
+    fq_nmod_reduce(b, ctx);
+    for ( size_t dx = 0; dx < prime_exponent; ++dx )
+      multiplication_matrix[dx*prime_exponent + ex] = nmod_poly_get_coeff_ui(b, dx);
 
-    fq_nmod_one(a, ctx);
-    for ( size_t ix=0; ix<prime_power-1; ++ix) {
-      unsigned int coeff_sum = 0;
-      for ( int dx = (int)prime_exponent-1; dx>=0; --dx ) {
-        coeff_sum *= prime;
-        coeff_sum += nmod_poly_get_coeff_ui(a,dx);
-      }
+    // the next basis element T^(ex+1)
+    fq_nmod_gen(b, ctx);
+    fq_nmod_mul(a, a, b, ctx);
+    fq_nmod_reduce(a, ctx);
+  }
 
-      if ( gen_powers.count(coeff_sum) != 0 ) {
-        is_gen = false;
-        break;
-      }
-      gen_powers[coeff_sum] = ix;
 
-      fq_nmod_mul(a, a, gen, ctx);
-      fq_nmod_reduce(a, ctx);
-    }
-  }
+  vector<int32_t> logarithms(prime_power);
+  logarithms.at(0) = prime_power_pred; // special index for 0
 
+  // each thread walks a chunk of powers, starting at a power of the generator
+  unsigned int nmb_threads = max(1u, thread::hardware_concurrency());
+  nmb_threads = min(nmb_threads, max(1u, prime_power_pred / ReductionTable::min_chunk_size));
 
-  auto incrementations = make_shared<vector<int32_t>>(prime_power);
-  incrementations->at(prime_power-1) = 0; // special index for 0
+  vector<vector<uint64_t>> initial_coeffs(nmb_threads, vector<uint64_t>(prime_exponent));
+  for ( unsigned int tx = 0; tx < nmb_threads; ++tx ) {
+    fq_nmod_pow_ui(a, gen, (size_t)prime_power_pred * tx / nmb_threads, ctx);
+    fq_nmod_reduce(a, ctx);
+    for ( size_t dx = 0; dx < prime_exponent; ++dx )
+      initial_coeffs[tx][dx] = nmod_poly_get_coeff_ui(a, dx);
+  }
 
-  for ( size_t pix=0; pix<prime_power-1; pix+=prime) {
-    for ( size_t ix=pix; ix<pix+prime-1; ++ix)
-      incrementations->at(gen_powers[ix]) = gen_powers[ix+1];
-    incrementations->at(gen_powers[pix+prime-1]) = gen_powers[pix];
+  if ( nmb_threads == 1 )
+    record_logarithms( logarithms, multiplication_matrix, initial_coeffs.front(),
+                       prime, 0, prime_power_pred );
+  else {
+    vector<thread> threads;
+    threads.reserve(nmb_threads);
+    for ( unsigned int tx = 0; tx < nmb_threads; ++tx )
+      threads.emplace_back( record_logarithms,
+                            ref(logarithms), cref(multiplication_matrix), initial_coeffs[tx], prime,
+                            (size_t)prime_power_pred * tx / nmb_threads,
+                            (size_t)prime_power_pred * (tx+1) / nmb_threads );
+    for ( auto & worker : threads )
+      worker.join();
   }
 
+  auto logarithm_table = make_shared<const LogarithmTable>(move(logarithms));
+  TableCache::store(ctx, "logarithms", *logarithm_table);
 
   flint_randclear(state);
   fq_nmod_clear(gen, ctx); 
   fq_nmod_clear(a, ctx); 
+  fq_nmod_clear(b, ctx); 
   fq_nmod_ctx_clear(ctx);
 
-  return incrementations;
+  return logarithm_table;
+}
+
+shared_ptr<const MappedTable<int32_t>>
+ReductionTable::
+compute_incrementation_table(
+    const LogarithmTable & logarithms
+    )
+{
+  vector<int32_t> incrementations(prime_power);
+  incrementations.at(prime_power-1) = 0; // special index for 0
+
+  // adding 1 increases the lowest digit of the label
+  for ( size_t pix=0; pix<prime_power-1; pix+=prime) {
+    for ( size_t ix=pix; ix<pix+prime-1; ++ix)
+      incrementations.at(logarithms[ix]) = logarithms[ix+1];
+    incrementations.at(logarithms[pix+prime-1]) = logarithms[pix];
+  }
+
+  return make_shared<const MappedTable<int32_t>>(move(incrementations));
+}
+
+shared_ptr<const MappedTable<CompactZechEntry>>
+ReductionTable::
+compute_compact_zech_table(
+    const MappedTable<int32_t> & incrementations
+    )
+{
+  const size_t cache_line_size = 64;
+  size_t nmb_entries = 2 * this->prime_power_pred + 1;
+  size_t size = (nmb_entries * sizeof(CompactZechEntry) + cache_line_size - 1)
+                / cache_line_size * cache_line_size;
+
+  auto zech_table = static_cast<CompactZechEntry*>(aligned_alloc(cache_line_size, size));
+  if ( zech_table == nullptr ) {
+    cerr << "ReductionTable.compute_compact_zech_table: could not allocate table" << endl;
+    throw;
+  }
+
+  for ( size_t ix = 0; ix < nmb_entries; ++ix ) {
+    zech_table[ix].reduction = ix % this->prime_power_pred;
+    zech_table[ix].incrementation = incrementations[ix % this->prime_power_pred];
+  }
+
+  return make_shared<const MappedTable<CompactZechEntry>>(
+             shared_ptr<const void>(zech_table, free), zech_table, nmb_entries );
+}
+
+shared_ptr<const MappedTable<int32_t>>
+ReductionTable::
+compute_additive_table(
+    const MappedTable<int32_t> & incrementations
+    )
+{
+  vector<int32_t> additive_labels(this->prime_power, -1);
+
+  // we start with the coset of 0, so that t*1 has label t
+  int32_t label = 0;
+  for ( size_t jx=0; jx<this->prime_power; ++jx ) {
+    size_t ix = (jx + this->prime_power_pred) % this->prime_power;
+    if ( additive_labels.at(ix) != -1 ) continue;
+
+    for ( size_t tx=0; tx<this->prime; ++tx, ++label ) {
+      additive_labels.at(ix) = label;
+      ix = incrementations[ix];
+    }
+  }
+
+  return make_shared<const MappedTable<int32_t>>(move(additive_labels));
+}
+
+shared_ptr<const MappedTable<int32_t>>
+ReductionTable::
+compute_additive_table_inverse(
+    const MappedTable<int32_t> & additive_labels
+    )
+{
+  vector<int32_t> exponents(this->prime_power);
+  for ( size_t ix=0; ix<this->prime_power; ++ix )
+    exponents.at(additive_labels[ix]) = ix;
+
+  return make_shared<const MappedTable<int32_t>>(move(exponents));
+}
+
+shared_ptr<vector<int32_t>>
+ReductionTable::
+compute_frobenius_orbit_representatives(
+    unsigned int base_exponent
+    )
+{
+  if ( base_exponent == 0 || this->prime_exponent % base_exponent != 0 ) {
+    cerr << "ReductionTable.compute_frobenius_orbit_representatives: "
+         << "base exponent must divide prime exponent: "
+         << base_exponent << " " << this->prime_exponent << endl;
+    throw;
+  }
+  unsigned int relative_exponent = this->prime_exponent / base_exponent;
+  unsigned int base_prime_power = pow(this->prime, base_exponent);
+
+  auto representatives = make_shared<vector<int32_t>>();
+  representatives->reserve(this->prime_power_pred / relative_exponent);
+
+  // Frobenius acts on exponents by multiplication with the base field size
+  vector<bool> visited(this->prime_power_pred, false);
+  for ( size_t ix=0; ix<this->prime_power_pred; ++ix ) {
+    if ( visited[ix] ) continue;
+
+    unsigned int orbit_size = 0;
+    size_t jx = ix;
+    do {
+      visited[jx] = true;
+      ++orbit_size;
+      jx = ((uint64_t)jx * base_prime_power) % this->prime_power_pred;
+    } while ( jx != ix );
+
+    if ( orbit_size == relative_exponent )
+      representatives->push_back(ix);
+  }
+
+  return representatives;
 }
@@ -24,10 +24,17 @@
 #ifndef _H_REDUCTION_TABLE
 #define _H_REDUCTION_TABLE
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
+#include "bitsliced_evaluation.hh"
+#include "logarithm_table.hh"
 #include "opencl/interface.hh"
+#include "small_field_kernels.hh"
 
 #ifdef WITH_OPENCL
   #include "opencl/buffer_evaluation.hh"
@@ -36,8 +43,52 @@
 #endif
 
 
+using std::lock_guard;
+using std::map;
+using std::mutex;
 using std::shared_ptr;
+using std::tuple;
 using std::vector;
+using std::weak_ptr;
+
+
+// the ways in which Curve::count evaluates on the cpu
+enum CountVariant
+{
+  // Zech tables, vectorized as far as the cpu supports
+  CountVariantTables,
+  // Zech tables without vector instructions
+  CountVariantScalarTables,
+  // residues instead of exponents, for prime fields with p < 2^16
+  CountVariantPrimeField,
+  // bitsliced evaluation for p = 3
+  CountVariantBitsliced
+};
+
+// the ways in which CurveBlock::count evaluates all curves of a block
+enum CurveBlockCountImplementation
+{
+  // evaluate all curves of the block on tiles of x
+  CurveBlockCountImplementationTiled,
+  // walk the block in Gray code order, updating the values f(x) for all x
+  CurveBlockCountImplementationGrayCode,
+  // over prime fields, count all constant coefficients at once by correlating
+  // the value histogram of f(x) - f(0) with the quadratic character;
+  // falls back to Gray code over other fields or if the constant coefficient is fixed
+  CurveBlockCountImplementationCorrelation,
+  // count each curve by the kernel for small fields with tables fixed at
+  // compile time; falls back to Gray code if there is no kernel
+  CurveBlockCountImplementationSmallField,
+  // the implementation that is set for the reduction table
+  CurveBlockCountImplementationTuned
+};
+
+// an entry of the interleaved reduction and incrementation tables
+struct CompactZechEntry
+{
+  uint16_t reduction;
+  uint16_t incrementation;
+};
 
 
 class ReductionTable
@@ -55,8 +106,40 @@ class ReductionTable
 
     void compute_tables();
     inline bool is_opencl_enabled() const { return (bool)opencl; };
+
+    bool is_count_variant_available(CountVariant variant) const;
+    void set_count_variant(CountVariant variant);
+    inline CountVariant count_variant() const { return this->_count_variant; };
+
+    // for p = 3, curves can be counted by bitsliced evaluation instead of
+    // table lookups
+    inline void enable_bitsliced_evaluation(bool enable = true)
+    {
+      this->set_count_variant(enable ? CountVariantBitsliced : CountVariantTables);
+    };
+    inline bool is_bitsliced_enabled() const { return this->_count_variant == CountVariantBitsliced; };
+
+    // the implementation by which blocks are counted if they leave the choice
+    // to the table, which is correlation unless set otherwise
+    void set_block_count_implementation(CurveBlockCountImplementation implementation);
+    inline CurveBlockCountImplementation block_count_implementation() const
+    {
+      return this->_block_count_implementation;
+    };
+
+    // an estimate of the memory held by the tables in bytes, including those
+    // that are built when they are first used
+    size_t memory_size() const;
+
+    // the exponents of elements labelled by their coefficients with respect to
+    // the polynomial basis of F_q over F_p as sum_i c_i p^i; field and
+    // reduction tables of the same field share one table while it is held
+    static shared_ptr<const LogarithmTable> logarithm_table(unsigned int prime, unsigned int prime_exponent);
     
+    friend class CountAutotuner;
     friend class Curve;
+    friend class CurveBlock;
+    friend class FqElementTable;
 #ifdef WITH_OPENCL
     friend OpenCLBufferEvaluation;
     friend OpenCLKernelEvaluation;
@@ -75,7 +158,40 @@ class ReductionTable
     shared_ptr<vector<int32_t>> exponent_reduction_table;
     // given a^i, tabulate the mod q-1 reduced j with a^j = 1 + a^i,
     // if there is any, and q-1 if there is non
-    shared_ptr<vector<int32_t>> incrementation_table;
+    shared_ptr<const MappedTable<int32_t>> incrementation_table;
+    // if q <= 2^16, both tables with 16 bit entries interleaved in one cache
+    // aligned allocation of 2(q-1) + 1 entries: the i-th entry holds the
+    // reduction of i and the incrementation of i mod q-1, so that the
+    // incrementation of a^(g-f) is found at g + (q-1) - f without swapping
+    shared_ptr<const MappedTable<CompactZechEntry>> compact_zech_table;
+    // only built once the bitsliced variant is selected
+    shared_ptr<BitslicedEvaluation> bitsliced_evaluation;
+    CountVariant _count_variant;
+    CurveBlockCountImplementation _block_count_implementation;
+
+    // the kernel with tables fixed at compile time if q is small
+    SmallFieldKernel small_field_kernel;
+    // the additive label of a^i is p*w + t, where w enumerates the cosets of F_p
+    // and adding 1 increases t modulo p; the coset of 0 is w = 0 and t*1 has label t
+    shared_ptr<const MappedTable<int32_t>> additive_table;
+    // the exponents of elements given by their additive label
+    shared_ptr<const MappedTable<int32_t>> additive_table_inverse;
+
+    // representatives of the Frobenius orbits with respect to F_{p^base_exponent}
+    // of those a^i that generate F_q over F_{p^base_exponent}; tables are
+    // shared among threads, which may request them concurrently
+    inline shared_ptr<vector<int32_t>> frobenius_orbit_representatives(unsigned int base_exponent)
+    {
+      lock_guard<mutex> representatives_lock(this->frobenius_orbit_representatives_mutex);
+      auto representatives_it = this->_frobenius_orbit_representatives.find(base_exponent);
+      if ( representatives_it == this->_frobenius_orbit_representatives.end() ) {
+        this->_frobenius_orbit_representatives[base_exponent] =
+            this->compute_frobenius_orbit_representatives(base_exponent);
+        return this->_frobenius_orbit_representatives[base_exponent];
+      }
+      else
+        return representatives_it->second;
+    };
 
 #ifdef WITH_OPENCL
     inline shared_ptr<OpenCLBufferEvaluation> buffer_evaluation() const
@@ -102,8 +218,29 @@ class ReductionTable
 
   private:
     shared_ptr<vector<int32_t>> compute_exponent_reduction_table(unsigned int prime_power);
-    shared_ptr<vector<int32_t>>
-        compute_incrementation_table(unsigned int prime, unsigned int prime_exponent, unsigned int prime_power);
+    static shared_ptr<const LogarithmTable>
+        compute_logarithm_table(unsigned int prime, unsigned int prime_exponent, unsigned int prime_power);
+    // the tables derived from the logarithm table, which are mapped from the
+    // table cache if it is enabled
+    shared_ptr<const MappedTable<int32_t>> compute_incrementation_table(const LogarithmTable & logarithms);
+    shared_ptr<const MappedTable<CompactZechEntry>>
+        compute_compact_zech_table(const MappedTable<int32_t> & incrementations);
+    shared_ptr<const MappedTable<int32_t>> compute_additive_table(const MappedTable<int32_t> & incrementations);
+    shared_ptr<const MappedTable<int32_t>>
+        compute_additive_table_inverse(const MappedTable<int32_t> & additive_labels);
+    shared_ptr<vector<int32_t>> compute_frobenius_orbit_representatives(unsigned int base_exponent);
+
+    map<unsigned int, shared_ptr<vector<int32_t>>> _frobenius_orbit_representatives;
+    // both are locked by memory_size
+    mutable mutex frobenius_orbit_representatives_mutex;
+    mutable mutex bitsliced_evaluation_mutex;
+
+    static map<tuple<unsigned int,unsigned int>, weak_ptr<const LogarithmTable>> logarithm_tables;
+    static mutex logarithm_tables_mutex;
+
+    // the least number of powers of the generator that compute_logarithm_table
+    // gives to a thread
+    static const unsigned int min_chunk_size;
 
 #ifdef WITH_OPENCL
     shared_ptr<OpenCLBufferEvaluation> _buffer_evaluation;
@@ -112,6 +249,55 @@ class ReductionTable
 #endif
 };
 
+
+// given f and tmp, which are both exponents of nonzero elements or zero indices,
+// compute the exponent of a^f + a^tmp
+inline
+unsigned int
+add_exponents(
+    unsigned int f,
+    unsigned int tmp,
+    unsigned int prime_power_pred,
+    const vector<int32_t> & exponent_reduction_table,
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+  if ( f == prime_power_pred ) // i.e. f = 0
+    return tmp;
+  if ( tmp == prime_power_pred ) // i.e. tmp = 0
+    return f;
+
+  if ( tmp < f ) {
+    unsigned int tmp2 = f;
+    f = tmp;
+    tmp = tmp2;
+  }
+  unsigned int inc = incrementation_table[tmp-f];
+  if ( inc == prime_power_pred )
+    return prime_power_pred;
+  return exponent_reduction_table[f + inc];
+}
+
+// the same as add_exponents for compact tables without branches, where
+// selections compile to conditional moves
+inline
+unsigned int
+add_exponents(
+    unsigned int f,
+    unsigned int tmp,
+    unsigned int prime_power_pred,
+    const CompactZechEntry * zech_table
+    )
+{
+  unsigned int inc = zech_table[tmp + prime_power_pred - f].incrementation;
+  unsigned int sum = zech_table[f + inc].reduction;
+
+  sum = inc == prime_power_pred ? prime_power_pred : sum;
+  sum = f == prime_power_pred ? tmp : sum;
+  sum = tmp == prime_power_pred ? f : sum;
+  return sum;
+}
+
 #endif
 
 
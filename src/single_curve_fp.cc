@@ -20,7 +20,9 @@
 
 ===============================================================================*/
 
+#include <algorithm>
 #include <cmath>
+#include <thread>
 
 #ifdef TIMING
 #include <chrono>
@@ -58,6 +60,7 @@ single_curve_fp(
 
   shared_ptr<OpenCLInterface> opencl;
   if (  implementation == SingleCurveCountImplementationCPU
+     || implementation == SingleCurveCountImplementationPrimeField
      || implementation == SingleCurveCountImplementationNaiveNMod
      || implementation == SingleCurveCountImplementationNaiveZech )
     opencl = shared_ptr<OpenCLInterface>();
@@ -94,7 +97,23 @@ single_curve_fp(
     }
   }
   else {
-    for ( size_t fx=curve->genus(); fx>0; --fx ) {
+    if ( implementation == SingleCurveCountImplementationPrimeField ) {
+#ifdef TIMING
+      start = chrono::steady_clock::now();
+#endif
+      curve->count_prime_field();
+#ifdef TIMING
+      cerr << "  TIMING: counting prime field "
+           << curve->prime_power() << endl
+           << "    "
+           << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()
+           << " ms" << endl;
+#endif
+    }
+
+    // counting over extensions uses counts over subfields
+    for ( size_t fx=1; fx<=curve->genus(); ++fx ) {
+      if ( curve->has_counted(fx) ) continue;
 #ifdef TIMING
       start = chrono::steady_clock::now();
 #endif
@@ -107,7 +126,8 @@ single_curve_fp(
            << " ms" << endl;
       start = chrono::steady_clock::now();
 #endif
-      curve->count(reduction_table);
+      // a single curve is counted with all cores
+      curve->count(reduction_table, max(1u, thread::hardware_concurrency()));
 #ifdef TIMING
       cerr << "  TIMING: counting total "
            << curve->prime_power() << "^" << fx << endl
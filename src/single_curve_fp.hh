@@ -38,7 +38,8 @@ enum SingleCurveCountImplementation
   SingleCurveCountImplementationCPU,
   SingleCurveCountImplementationOpenCL,
   SingleCurveCountImplementationNaiveNMod,
-  SingleCurveCountImplementationNaiveZech
+  SingleCurveCountImplementationNaiveZech,
+  SingleCurveCountImplementationPrimeField
 };
 
 shared_ptr<Curve>
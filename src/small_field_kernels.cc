@@ -0,0 +1,316 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include "small_field_kernels.hh"
+
+
+using namespace std;
+
+
+static constexpr
+unsigned int
+least_primitive_root(
+    unsigned int prime
+    )
+{
+  for ( unsigned int gx = 2; gx < prime; ++gx ) {
+    unsigned int order = 1;
+    for ( unsigned int a = gx; a != 1; a = a * gx % prime )
+      ++order;
+    if ( order == prime - 1 )
+      return gx;
+  }
+  return 1;
+}
+
+static constexpr
+unsigned int
+small_field_prime_power(
+    unsigned int prime,
+    unsigned int prime_exponent
+    )
+{
+  unsigned int prime_power = 1;
+  for ( unsigned int ex = 0; ex < prime_exponent; ++ex )
+    prime_power *= prime;
+  return prime_power;
+}
+
+const unsigned int small_field_max_prime_exponent = 5;
+
+// the coefficients c_0, ..., c_(r-1) of the Conway polynomial
+// T^r + c_(r-1) T^(r-1) + ... + c_0 for the extension fields with kernels
+struct ConwayPolynomial
+{
+  unsigned int prime;
+  unsigned int prime_exponent;
+  unsigned int coefficients[small_field_max_prime_exponent];
+};
+
+static constexpr ConwayPolynomial conway_polynomials[] =
+  { {  3, 2, {2, 2} }
+  , {  3, 3, {1, 2, 0} }
+  , {  3, 4, {2, 0, 0, 2} }
+  , {  3, 5, {1, 2, 0, 0, 0} }
+  , {  5, 2, {2, 4} }
+  , {  5, 3, {3, 3, 0} }
+  , {  7, 2, {3, 6} }
+  , { 11, 2, {2, 7} }
+  , { 13, 2, {2, 12} }
+  };
+
+static constexpr
+unsigned int
+conway_polynomial_coefficient(
+    unsigned int prime,
+    unsigned int prime_exponent,
+    unsigned int dx
+    )
+{
+  // over prime fields the Conway polynomial is T - g for the least primitive root g
+  if ( prime_exponent == 1 )
+    return prime - least_primitive_root(prime);
+
+  for ( const auto & polynomial : conway_polynomials )
+    if ( polynomial.prime == prime && polynomial.prime_exponent == prime_exponent )
+      return polynomial.coefficients[dx];
+  return 0;
+}
+
+// The exponents are taken with respect to the root a of the Conway
+// polynomial, and q - 1 is the index of zero. As in the compact tables of
+// ReductionTable both tables have 2(q-1) + 1 entries, so that exponents can
+// be added without swapping them. Elements are labelled as
+// sum_i c_i p^i by their coefficients with respect to the basis a^i.
+template <unsigned int prime, unsigned int prime_exponent>
+struct SmallFieldTables
+{
+  static constexpr unsigned int prime_power = small_field_prime_power(prime, prime_exponent);
+
+  uint8_t exponent_reduction_table[2*(prime_power-1) + 1];
+  uint8_t incrementation_table[2*(prime_power-1) + 1];
+  // bit i is set if a^i is a nonzero square, including a word for the index of zero
+  uint64_t square_mask[(prime_power-1) / 64 + 1];
+
+  constexpr
+  SmallFieldTables() :
+    exponent_reduction_table{},
+    incrementation_table{},
+    square_mask{}
+  {
+    unsigned int powers[prime_power-1] = {};
+    unsigned int logarithms[prime_power] = {};
+
+    // multiplication by a shifts the coefficients and reduces T^r by the
+    // Conway polynomial
+    unsigned int coeffs[prime_exponent] = {};
+    coeffs[0] = 1;
+    for ( unsigned int ix = 0; ix < prime_power-1; ++ix ) {
+      unsigned int label = 0;
+      for ( unsigned int dx = prime_exponent; dx-- > 0; )
+        label = label * prime + coeffs[dx];
+      powers[ix] = label;
+      logarithms[label] = ix;
+
+      unsigned int top = coeffs[prime_exponent-1];
+      for ( unsigned int dx = prime_exponent; dx-- > 0; ) {
+        unsigned int reduction = top * conway_polynomial_coefficient(prime, prime_exponent, dx) % prime;
+        coeffs[dx] = ((dx == 0 ? 0 : coeffs[dx-1]) + prime - reduction) % prime;
+      }
+    }
+
+    for ( unsigned int ix = 0; ix < 2*(prime_power-1) + 1; ++ix ) {
+      this->exponent_reduction_table[ix] = ix % (prime_power-1);
+
+      // adding 1 changes the constant coefficient, which is the lowest digit
+      unsigned int label = powers[ix % (prime_power-1)];
+      unsigned int incremented = label - label % prime + (label + 1) % prime;
+      this->incrementation_table[ix] = incremented == 0 ? prime_power-1 : logarithms[incremented];
+    }
+
+    for ( unsigned int ix = 0; ix < prime_power-1; ix += 2 )
+      this->square_mask[ix / 64] |= (uint64_t)1 << (ix % 64);
+  }
+};
+
+template <unsigned int prime, unsigned int prime_exponent>
+static constexpr SmallFieldTables<prime, prime_exponent> small_field_tables{};
+
+
+template <unsigned int prime, unsigned int prime_exponent>
+static inline
+unsigned int
+add_small_field_exponents(
+    unsigned int f,
+    unsigned int tmp
+    )
+{
+  const auto & tables = small_field_tables<prime, prime_exponent>;
+  constexpr unsigned int prime_power_pred = SmallFieldTables<prime, prime_exponent>::prime_power - 1;
+
+  unsigned int inc = tables.incrementation_table[tmp + prime_power_pred - f];
+  unsigned int sum = tables.exponent_reduction_table[f + inc];
+
+  sum = inc == prime_power_pred ? prime_power_pred : sum;
+  sum = f == prime_power_pred ? tmp : sum;
+  sum = tmp == prime_power_pred ? f : sum;
+  return sum;
+}
+
+template <unsigned int prime, unsigned int prime_exponent>
+static
+void
+count_small_field(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    )
+{
+  // Horner's scheme, where multiplication by x is adding its exponent
+  const auto & tables = small_field_tables<prime, prime_exponent>;
+  constexpr unsigned int prime_power_pred = SmallFieldTables<prime, prime_exponent>::prime_power - 1;
+  size_t poly_size = poly_coeff_exponents.size();
+
+  for ( unsigned int x = 0; x < prime_power_pred; ++x ) {
+    unsigned int f = poly_coeff_exponents.back();
+    for ( size_t dx = poly_size - 1; dx-- > 0; ) {
+      unsigned int fx = tables.exponent_reduction_table[f + x];
+      fx = f == prime_power_pred ? prime_power_pred : fx;
+      f = add_small_field_exponents<prime, prime_exponent>(fx, poly_coeff_exponents[dx]);
+    }
+
+    nmb_ramified += f == prime_power_pred;
+    nmb_unramified += 2 * ((tables.square_mask[f / 64] >> (f % 64)) & 1);
+  }
+}
+
+template <unsigned int prime, unsigned int prime_exponent>
+static
+SmallFieldKernel
+checked_small_field_kernel(
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+  // the tables hold if the generator of the reduction table is the root of the Conway polynomial
+  const auto & tables = small_field_tables<prime, prime_exponent>;
+  constexpr unsigned int prime_power_pred = SmallFieldTables<prime, prime_exponent>::prime_power - 1;
+  if ( incrementation_table.size() < prime_power_pred )
+    return nullptr;
+  for ( size_t ix = 0; ix < prime_power_pred; ++ix )
+    if ( incrementation_table[ix] != tables.incrementation_table[ix] )
+      return nullptr;
+  return &count_small_field<prime, prime_exponent>;
+}
+
+
+SmallFieldKernel
+small_field_kernel(
+    unsigned int prime,
+    unsigned int prime_exponent,
+    const MappedTable<int32_t> & incrementation_table
+    )
+{
+  if ( prime_exponent == 1 )
+    switch ( prime ) {
+      case   3: return checked_small_field_kernel<  3,1>(incrementation_table);
+      case   5: return checked_small_field_kernel<  5,1>(incrementation_table);
+      case   7: return checked_small_field_kernel<  7,1>(incrementation_table);
+      case  11: return checked_small_field_kernel< 11,1>(incrementation_table);
+      case  13: return checked_small_field_kernel< 13,1>(incrementation_table);
+      case  17: return checked_small_field_kernel< 17,1>(incrementation_table);
+      case  19: return checked_small_field_kernel< 19,1>(incrementation_table);
+      case  23: return checked_small_field_kernel< 23,1>(incrementation_table);
+      case  29: return checked_small_field_kernel< 29,1>(incrementation_table);
+      case  31: return checked_small_field_kernel< 31,1>(incrementation_table);
+      case  37: return checked_small_field_kernel< 37,1>(incrementation_table);
+      case  41: return checked_small_field_kernel< 41,1>(incrementation_table);
+      case  43: return checked_small_field_kernel< 43,1>(incrementation_table);
+      case  47: return checked_small_field_kernel< 47,1>(incrementation_table);
+      case  53: return checked_small_field_kernel< 53,1>(incrementation_table);
+      case  59: return checked_small_field_kernel< 59,1>(incrementation_table);
+      case  61: return checked_small_field_kernel< 61,1>(incrementation_table);
+      case  67: return checked_small_field_kernel< 67,1>(incrementation_table);
+      case  71: return checked_small_field_kernel< 71,1>(incrementation_table);
+      case  73: return checked_small_field_kernel< 73,1>(incrementation_table);
+      case  79: return checked_small_field_kernel< 79,1>(incrementation_table);
+      case  83: return checked_small_field_kernel< 83,1>(incrementation_table);
+      case  89: return checked_small_field_kernel< 89,1>(incrementation_table);
+      case  97: return checked_small_field_kernel< 97,1>(incrementation_table);
+      case 101: return checked_small_field_kernel<101,1>(incrementation_table);
+      case 103: return checked_small_field_kernel<103,1>(incrementation_table);
+      case 107: return checked_small_field_kernel<107,1>(incrementation_table);
+      case 109: return checked_small_field_kernel<109,1>(incrementation_table);
+      case 113: return checked_small_field_kernel<113,1>(incrementation_table);
+      case 127: return checked_small_field_kernel<127,1>(incrementation_table);
+      case 131: return checked_small_field_kernel<131,1>(incrementation_table);
+      case 137: return checked_small_field_kernel<137,1>(incrementation_table);
+      case 139: return checked_small_field_kernel<139,1>(incrementation_table);
+      case 149: return checked_small_field_kernel<149,1>(incrementation_table);
+      case 151: return checked_small_field_kernel<151,1>(incrementation_table);
+      case 157: return checked_small_field_kernel<157,1>(incrementation_table);
+      case 163: return checked_small_field_kernel<163,1>(incrementation_table);
+      case 167: return checked_small_field_kernel<167,1>(incrementation_table);
+      case 173: return checked_small_field_kernel<173,1>(incrementation_table);
+      case 179: return checked_small_field_kernel<179,1>(incrementation_table);
+      case 181: return checked_small_field_kernel<181,1>(incrementation_table);
+      case 191: return checked_small_field_kernel<191,1>(incrementation_table);
+      case 193: return checked_small_field_kernel<193,1>(incrementation_table);
+      case 197: return checked_small_field_kernel<197,1>(incrementation_table);
+      case 199: return checked_small_field_kernel<199,1>(incrementation_table);
+      case 211: return checked_small_field_kernel<211,1>(incrementation_table);
+      case 223: return checked_small_field_kernel<223,1>(incrementation_table);
+      case 227: return checked_small_field_kernel<227,1>(incrementation_table);
+      case 229: return checked_small_field_kernel<229,1>(incrementation_table);
+      case 233: return checked_small_field_kernel<233,1>(incrementation_table);
+      case 239: return checked_small_field_kernel<239,1>(incrementation_table);
+      case 241: return checked_small_field_kernel<241,1>(incrementation_table);
+      case 251: return checked_small_field_kernel<251,1>(incrementation_table);
+      default: return nullptr;
+    }
+
+  switch ( prime ) {
+    case 3:
+      switch ( prime_exponent ) {
+        case 2: return checked_small_field_kernel<3,2>(incrementation_table);
+        case 3: return checked_small_field_kernel<3,3>(incrementation_table);
+        case 4: return checked_small_field_kernel<3,4>(incrementation_table);
+        case 5: return checked_small_field_kernel<3,5>(incrementation_table);
+        default: return nullptr;
+      }
+    case 5:
+      switch ( prime_exponent ) {
+        case 2: return checked_small_field_kernel<5,2>(incrementation_table);
+        case 3: return checked_small_field_kernel<5,3>(incrementation_table);
+        default: return nullptr;
+      }
+    case 7:
+      return prime_exponent == 2 ? checked_small_field_kernel<7,2>(incrementation_table) : nullptr;
+    case 11:
+      return prime_exponent == 2 ? checked_small_field_kernel<11,2>(incrementation_table) : nullptr;
+    case 13:
+      return prime_exponent == 2 ? checked_small_field_kernel<13,2>(incrementation_table) : nullptr;
+    default:
+      return nullptr;
+  }
+}
@@ -0,0 +1,65 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+
+#ifndef _H_SMALL_FIELD_KERNELS
+#define _H_SMALL_FIELD_KERNELS
+
+#include <cstdint>
+#include <vector>
+
+#include "logarithm_table.hh"
+
+
+using std::vector;
+
+
+// Counting kernels for fields F_q of odd characteristic with q < 256, that
+// is prime fields and the extensions of degree up to 5 of F_3, up to 3 of
+// F_5, and 2 of F_7, F_11, and F_13. Their tables are generated at compile
+// time as uint8_t arrays with respect to the root of the Conway polynomial,
+// which over prime fields is the least primitive root. The quadratic
+// character is read off from a bitmask of exponents with one bit for each
+// element, which spans several words.
+
+const unsigned int small_field_max_prime_power = 251;
+
+// evaluate at all nonzero x and add the numbers of points
+typedef void (*SmallFieldKernel)(
+    const vector<unsigned int> & poly_coeff_exponents,
+    unsigned int & nmb_unramified,
+    unsigned int & nmb_ramified
+    );
+
+// the kernel for F_q, q = prime^prime_exponent, if there is one and if its
+// tables agree with the given incrementation table, and a null pointer
+// otherwise
+SmallFieldKernel
+small_field_kernel(
+    unsigned int prime,
+    unsigned int prime_exponent,
+    const MappedTable<int32_t> & incrementation_table
+    );
+
+#endif
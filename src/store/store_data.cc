@@ -33,6 +33,6 @@ ValueType(
     const string & str
     )
 {
-  fmpz_init(this->counter);
-  fmpz_set_str(this->counter, str.c_str(), 10);
+  fmpq_init(this->counter);
+  fmpq_set_str(this->counter, str.c_str(), 10);
 };
@@ -25,12 +25,16 @@
 #define _H_STORE_STORE_DATA
 
 
+#include "flint/fmpq.h"
 #include "flint/fmpz.h"
 #include <iostream>
 #include <set>
 #include <string>
 
+#include "factorization_pattern_iterator.hh"
 
+
+using std::get;
 using std::istream;
 using std::ostream;
 using std::move;
@@ -46,11 +50,29 @@ namespace StoreData
 class Count
 {
   public:
+    // Under projective normalization, orbit weights need not be integral for
+    // single curves, but their sums over all curves of a given type are.
     inline Count(const Curve & curve)
     {
-      CurveIterator::multiplicity( value.counter,
-          curve.prime(), curve.prime_power(),
-          curve.rhs_support() );
+      if ( curve.normalization() == CurveIteratorNormalizationProjective )
+        CurveIterator::projective_multiplicity( value.counter,
+            curve.prime(), curve.prime_power(),
+            curve.rhs_support(),
+            get<1>(curve.number_of_points().at(curve.prime_exponent())) );
+      else if ( curve.enumeration() == CurveEnumerationFactorizationPattern )
+        FactorizationPatternIterator::multiplicity( fmpq_numref(value.counter),
+            curve.prime_power(), curve.orbit_size() );
+      else
+        CurveIterator::multiplicity( fmpq_numref(value.counter),
+            curve.prime(), curve.prime_power(),
+            curve.rhs_support() );
+
+      if ( curve.galois_multiplicity() != 1 ) {
+        fmpz_t galois_mult;
+        fmpz_init_set_ui(galois_mult, curve.galois_multiplicity());
+        fmpq_mul_fmpz(value.counter, value.counter, galois_mult);
+        fmpz_clear(galois_mult);
+      }
     };
     
     inline const Count twist() { return *this; };
@@ -62,30 +84,30 @@ class Count
 
     struct ValueType
     {
-      fmpz_t counter;
+      fmpq_t counter;
 
       ValueType()
       {
-        fmpz_init(this->counter);
+        fmpq_init(this->counter);
       };
 
       ValueType(unsigned int counter)
       {
-        fmpz_init(this->counter);
-        fmpz_set_ui(this->counter, counter);
+        fmpq_init(this->counter);
+        fmpq_set_si(this->counter, counter, 1);
       };
 
       ValueType(const Count & count)
       {
-        fmpz_init(this->counter);
-        fmpz_set(this->counter, count.value.counter);
+        fmpq_init(this->counter);
+        fmpq_set(this->counter, count.value.counter);
       };
 
       ValueType(const string & str);
 
       ~ValueType()
       {
-        fmpz_clear(this->counter);
+        fmpq_clear(this->counter);
       };
     };
 
@@ -103,23 +125,23 @@ class Count
 
 inline bool operator==(const Count::ValueType & lhs, const Count::ValueType & rhs)
 {
-  return fmpz_equal(lhs.counter, rhs.counter) == 1;
+  return fmpq_equal(lhs.counter, rhs.counter) == 1;
 };
 
 inline void operator+=(Count::ValueType & lhs, const Count::ValueType & rhs)
 {
-  fmpz_add(lhs.counter, lhs.counter, rhs.counter);
+  fmpq_add(lhs.counter, lhs.counter, rhs.counter);
 };
 
 inline void operator+=(Count::ValueType & lhs, const Count & rhs)
 {
-  fmpz_add(lhs.counter, lhs.counter, rhs.value.counter);
+  fmpq_add(lhs.counter, lhs.counter, rhs.value.counter);
 };
 
 
 inline ostream & operator<<(ostream & stream, const Count::ValueType & value)
 {
-  char * c_str = fmpz_get_str(NULL, 10, value.counter);
+  char * c_str = fmpq_get_str(NULL, 10, value.counter);
   stream << string(c_str);
   flint_free(c_str);
 
@@ -0,0 +1,205 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <flint/fmpz.h>
+#include <flint/nmod_poly.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "table_cache.hh"
+
+
+using namespace std;
+using boost::filesystem::create_directories;
+using boost::filesystem::exists;
+using boost::filesystem::rename;
+using boost::filesystem::unique_path;
+
+
+const uint32_t TableCache::version = 2;
+const char TableCache::magic[8] = { 'H', 'y', 'C', 'u', 'T', 'a', 'b', '\0' };
+
+
+bool
+TableCache::
+is_enabled()
+{
+  return !TableCache::cache_directory().empty();
+}
+
+path
+TableCache::
+cache_directory()
+{
+  const char * cache_path = getenv("HYCU_TABLE_CACHE");
+  if ( cache_path == nullptr )
+    return path();
+  return path(cache_path);
+}
+
+path
+TableCache::
+table_path(
+    const fq_nmod_ctx_t ctx,
+    const char * name
+    )
+{
+  stringstream filename;
+  filename << name << "_" << fmpz_get_ui(fq_nmod_ctx_prime(ctx))
+           << "_" << fq_nmod_ctx_degree(ctx)
+           << ".v" << TableCache::version;
+  return TableCache::cache_directory() / filename.str();
+}
+
+vector<uint32_t>
+TableCache::
+header(
+    const fq_nmod_ctx_t ctx
+    )
+{
+  // version, prime, prime exponent, and the coefficients of the modulus
+  vector<uint32_t> header;
+  header.push_back(TableCache::version);
+  header.push_back(fmpz_get_ui(fq_nmod_ctx_prime(ctx)));
+  header.push_back(fq_nmod_ctx_degree(ctx));
+  for ( slong dx = 0; dx <= fq_nmod_ctx_degree(ctx); ++dx )
+    header.push_back(nmod_poly_get_coeff_ui(ctx->modulus, dx));
+
+  return header;
+}
+
+size_t
+TableCache::
+header_size(
+    const vector<uint32_t> & header
+    )
+{
+  const size_t cache_line_size = 64;
+  size_t size = sizeof(TableCache::magic) + header.size() * sizeof(uint32_t);
+  return (size + cache_line_size - 1) / cache_line_size * cache_line_size;
+}
+
+const void *
+TableCache::
+map_entries(
+    const fq_nmod_ctx_t ctx,
+    const char * name,
+    size_t size,
+    shared_ptr<const void> & mapping
+    )
+{
+  if ( !TableCache::is_enabled() )
+    return nullptr;
+
+  path table_path = TableCache::table_path(ctx, name);
+  int fd = open(table_path.c_str(), O_RDONLY);
+  if ( fd == -1 )
+    return nullptr;
+
+  auto header = TableCache::header(ctx);
+  size_t header_size = TableCache::header_size(header);
+  size_t file_size = header_size + size;
+
+  struct stat table_stat;
+  if ( fstat(fd, &table_stat) == -1 || (size_t)table_stat.st_size != file_size ) {
+    close(fd);
+    cerr << "TableCache: ignoring " << table_path << " of unexpected size" << endl;
+    return nullptr;
+  }
+
+  void * table_map = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( table_map == MAP_FAILED )
+    return nullptr;
+  mapping = shared_ptr<const void>( table_map,
+                                    [file_size](const void * map) { munmap(const_cast<void*>(map), file_size); } );
+
+  const char * table_bytes = static_cast<const char*>(table_map);
+  if (    memcmp(table_bytes, TableCache::magic, sizeof(TableCache::magic)) != 0
+       || memcmp(table_bytes + sizeof(TableCache::magic), header.data(), header.size() * sizeof(uint32_t)) != 0 ) {
+    cerr << "TableCache: ignoring " << table_path << " for a different field" << endl;
+    mapping.reset();
+    return nullptr;
+  }
+
+  // the table refers to the mapped entries and keeps the mapping
+  return table_bytes + header_size;
+}
+
+void
+TableCache::
+write_entries(
+    const fq_nmod_ctx_t ctx,
+    const char * name,
+    const void * entries,
+    size_t size
+    )
+{
+  if ( !TableCache::is_enabled() )
+    return;
+
+  path table_path = TableCache::table_path(ctx, name);
+  if ( exists(table_path) )
+    return;
+
+  boost::system::error_code error;
+  create_directories(TableCache::cache_directory(), error);
+
+  // other processes may write the same table, so we write to a file of our
+  // own and move it into place
+  path tmp_path( table_path.native() + unique_path(".%%%%-%%%%-%%%%").native() );
+
+  auto header = TableCache::header(ctx);
+  vector<char> padding(TableCache::header_size(header) - sizeof(TableCache::magic)
+                       - header.size() * sizeof(uint32_t), 0);
+  {
+    ofstream table_file(tmp_path.native(), ios_base::out | ios_base::binary);
+    table_file.write(TableCache::magic, sizeof(TableCache::magic));
+    table_file.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(uint32_t));
+    table_file.write(padding.data(), padding.size());
+    table_file.write(static_cast<const char*>(entries), size);
+    if ( !table_file ) {
+      cerr << "TableCache: could not write " << tmp_path << endl;
+      boost::filesystem::remove(tmp_path, error);
+      return;
+    }
+  }
+
+  rename(tmp_path, table_path, error);
+  if ( error ) {
+    cerr << "TableCache: could not write " << table_path << endl;
+    boost::filesystem::remove(tmp_path, error);
+  }
+}
@@ -0,0 +1,103 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#ifndef _H_TABLE_CACHE
+#define _H_TABLE_CACHE
+
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <flint/fq_nmod.h>
+#include <memory>
+#include <vector>
+
+#include "logarithm_table.hh"
+
+
+using boost::filesystem::path;
+using std::shared_ptr;
+using std::vector;
+
+
+// Cache of the tables of finite fields on disk: the logarithm tables, from
+// which both ReductionTable and FqElementTable are built without searching
+// for a generator, and the Zech and label tables derived from them. The cache
+// is kept in the directory that the environment variable HYCU_TABLE_CACHE
+// names. Files are written once and mapped read only. Loaded tables keep their
+// mapping, so that processes on one node share them through the page cache.
+// Files record the defining polynomial of the field, and a table is used only
+// if it matches the one of the context.
+class TableCache
+{
+  public:
+    static bool is_enabled();
+
+    // a table of size entries that is backed by the mapped file; empty if not
+    // cached
+    template<typename T>
+    static shared_ptr<const MappedTable<T>> load(const fq_nmod_ctx_t ctx, const char * name, size_t size)
+    {
+      shared_ptr<const void> mapping;
+      const void * entries = TableCache::map_entries(ctx, name, size * sizeof(T), mapping);
+      if ( entries == nullptr )
+        return shared_ptr<const MappedTable<T>>();
+      return std::make_shared<const MappedTable<T>>(mapping, static_cast<const T*>(entries), size);
+    };
+
+    template<typename T>
+    static void store(const fq_nmod_ctx_t ctx, const char * name, const MappedTable<T> & table)
+    {
+      TableCache::write_entries(ctx, name, table.data(), table.size() * sizeof(T));
+    };
+
+    // the table that is mapped from the cache, or else the one that compute
+    // returns, which is then stored
+    template<typename T, typename Compute>
+    static shared_ptr<const MappedTable<T>>
+        load_or_compute(const fq_nmod_ctx_t ctx, const char * name, size_t size, Compute compute)
+    {
+      auto table = TableCache::load<T>(ctx, name, size);
+      if ( !table ) {
+        table = compute();
+        TableCache::store(ctx, name, *table);
+      }
+      return table;
+    };
+
+  private:
+    // increased whenever the format or the choice of generators changes
+    static const uint32_t version;
+    static const char magic[8];
+
+    static path cache_directory();
+    static path table_path(const fq_nmod_ctx_t ctx, const char * name);
+    static vector<uint32_t> header(const fq_nmod_ctx_t ctx);
+    // the header is padded to a cache line, so that entries are aligned
+    static size_t header_size(const vector<uint32_t> & header);
+
+    static const void * map_entries( const fq_nmod_ctx_t ctx, const char * name, size_t size,
+                                     shared_ptr<const void> & mapping );
+    static void write_entries(const fq_nmod_ctx_t ctx, const char * name, const void * entries, size_t size);
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "table_registry.hh"
+
+
+using namespace std;
+
+
+mutex TableRegistry::registry_mutex;
+map<tuple<unsigned int,unsigned int>, weak_ptr<FqElementTable>> TableRegistry::fq_element_tables;
+map<tuple<unsigned int,unsigned int,const OpenCLInterface*>, weak_ptr<ReductionTable>>
+    TableRegistry::reduction_tables;
+list<tuple<shared_ptr<const void>,function<size_t()>,size_t>> TableRegistry::retained_tables;
+size_t TableRegistry::retention_budget = 0;
+size_t TableRegistry::retained_size = 0;
+
+
+shared_ptr<FqElementTable>
+TableRegistry::
+fq_element_table(
+    unsigned int prime,
+    unsigned int prime_exponent
+    )
+{
+  // tables are built while holding the lock, so that each is built only once
+  lock_guard<mutex> registry_lock(registry_mutex);
+
+  auto & table_weak = fq_element_tables[make_tuple(prime, prime_exponent)];
+  auto table = table_weak.lock();
+  if ( !table ) {
+    table = make_shared<FqElementTable>(prime, prime_exponent);
+    table_weak = table;
+  }
+  FqElementTable * table_raw = table.get();
+  TableRegistry::retain(table, [table_raw]() { return table_raw->memory_size(); });
+
+  return table;
+}
+
+shared_ptr<ReductionTable>
+TableRegistry::
+reduction_table(
+    unsigned int prime,
+    unsigned int prime_exponent,
+    const shared_ptr<OpenCLInterface> & opencl
+    )
+{
+  lock_guard<mutex> registry_lock(registry_mutex);
+
+  auto & table_weak = reduction_tables[make_tuple(prime, prime_exponent, opencl.get())];
+  auto table = table_weak.lock();
+  if ( !table ) {
+    table = make_shared<ReductionTable>(prime, prime_exponent, opencl);
+    table_weak = table;
+  }
+  ReductionTable * table_raw = table.get();
+  TableRegistry::retain(table, [table_raw]() { return table_raw->memory_size(); });
+
+  return table;
+}
+
+void
+TableRegistry::
+set_retention_budget(
+    size_t budget
+    )
+{
+  lock_guard<mutex> registry_lock(registry_mutex);
+
+  TableRegistry::retention_budget = budget;
+  TableRegistry::measure();
+  TableRegistry::evict();
+}
+
+size_t
+TableRegistry::
+retained_memory_size()
+{
+  lock_guard<mutex> registry_lock(registry_mutex);
+  TableRegistry::measure();
+  return TableRegistry::retained_size;
+}
+
+void
+TableRegistry::
+retain(
+    const shared_ptr<const void> & table,
+    function<size_t()> memory_size
+    )
+{
+  auto table_it = find_if( retained_tables.begin(), retained_tables.end(),
+                           [&table](const decltype(retained_tables)::value_type & retained)
+                             { return get<0>(retained) == table; } );
+  if ( table_it != retained_tables.end() )
+    retained_tables.splice(retained_tables.begin(), retained_tables, table_it);
+  else
+    retained_tables.emplace_front(table, move(memory_size), 0);
+
+  TableRegistry::measure();
+  TableRegistry::evict();
+}
+
+void
+TableRegistry::
+measure()
+{
+  // memory that tables built since the last measurement, like the bitsliced
+  // evaluation, counts against the budget as well
+  TableRegistry::retained_size = 0;
+  for ( auto & retained : retained_tables ) {
+    get<2>(retained) = get<1>(retained)();
+    TableRegistry::retained_size += get<2>(retained);
+  }
+}
+
+void
+TableRegistry::
+evict()
+{
+  // tables that are still held elsewhere remain registered
+  while ( TableRegistry::retained_size > TableRegistry::retention_budget ) {
+    TableRegistry::retained_size -= get<2>(retained_tables.back());
+    retained_tables.pop_back();
+  }
+}
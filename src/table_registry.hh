@@ -0,0 +1,90 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#ifndef _H_TABLE_REGISTRY
+#define _H_TABLE_REGISTRY
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "fq_element_table.hh"
+#include "opencl/interface.hh"
+#include "reduction_table.hh"
+
+
+using std::function;
+using std::list;
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::tuple;
+using std::weak_ptr;
+
+
+// Process wide registry of field and reduction tables, which are shared by
+// all threads. Tables are kept as long as some thread holds them. Reduction
+// tables with OpenCL carry buffers and kernels of one interface, so they are
+// shared only among the users of that interface.
+//
+// The most recently requested tables are in addition retained while their
+// total memory stays within a budget, so that a change of configuration only
+// builds the tables that are missing. Tables build some of their memory only
+// when it is first used, so their sizes are measured anew whenever the
+// registry is accessed.
+class TableRegistry
+{
+  public:
+    static shared_ptr<FqElementTable> fq_element_table(unsigned int prime, unsigned int prime_exponent);
+    static shared_ptr<ReductionTable>
+        reduction_table( unsigned int prime, unsigned int prime_exponent,
+                         const shared_ptr<OpenCLInterface> & opencl = shared_ptr<OpenCLInterface>() );
+
+    // the budget in bytes, which is 0 by default
+    static void set_retention_budget(size_t budget);
+    static size_t retained_memory_size();
+
+  private:
+    static mutex registry_mutex;
+
+    // retained tables with the measures of their memory and its last size,
+    // most recently requested first
+    static list<tuple<shared_ptr<const void>,function<size_t()>,size_t>> retained_tables;
+    static size_t retention_budget;
+    static size_t retained_size;
+
+    // all require the registry mutex
+    static void retain(const shared_ptr<const void> & table, function<size_t()> memory_size);
+    static void measure();
+    static void evict();
+
+    static map<tuple<unsigned int,unsigned int>, weak_ptr<FqElementTable>> fq_element_tables;
+    static map<tuple<unsigned int,unsigned int,const OpenCLInterface*>, weak_ptr<ReductionTable>>
+        reduction_tables;
+};
+
+#endif
@@ -20,6 +20,9 @@
 
 ===============================================================================*/
 
+#include "count_autotuner.hh"
+#include "curve_block.hh"
+#include "table_registry.hh"
 #include "threaded/thread.hh"
 #include "threaded/thread_pool.hh"
 
@@ -32,6 +35,7 @@ Thread::
 spark()
 {
   this->shutting_down = false;
+  this->has_stopped = false;
   this->main_std_thread = thread( Thread::main_thread, shared_from_this(), this->store_factory );
 }
 
@@ -43,6 +47,7 @@ shutdown()
   this->shutting_down = true;
   this->data_mutex.unlock();
 
+  // the main thread runs all pending tasks before it returns
   this->main_cond_var.notify_all();
   this->main_std_thread.join();
 }
@@ -54,53 +59,121 @@ main_thread(
     const shared_ptr<StoreFactoryInterface> store_factory
     )
 {
-  unique_lock<mutex> main_lock(thread->main_mutex);
+  // consecutive blocks often share their fixed coefficients
+  shared_ptr<FqElementTable> prefix_cache_fq_table;
+  shared_ptr<CurveBlockPrefixCache> prefix_cache;
 
   while ( true ) {
-    while ( true ) {
-      thread->data_mutex.lock();
-      bool shutting_down = thread->shutting_down;
-      bool blocks_empty = thread->blocks.empty();
-      thread->data_mutex.unlock();
-
-      if ( shutting_down )
-        return;
-
-      if ( blocks_empty )
-        thread->main_cond_var.wait(main_lock);
-      else
-        break;
+    // the state is tested and waited for under the same lock, so that no
+    // notification is lost in between
+    unique_lock<mutex> data_lock(thread->data_mutex);
+    thread->main_cond_var.wait( data_lock, [&thread]() {
+        return thread->shutting_down || !thread->tasks.empty() || !thread->blocks.empty();
+      } );
+
+    // the threads that borrowed this one wait for their tasks, which are
+    // therefore run even when shutting down
+    if ( !thread->tasks.empty() ) {
+      function<void()> task = move(thread->tasks.front());
+      thread->tasks.pop_front();
+      data_lock.unlock();
+
+      task();
+      continue;
+    }
+
+    if ( thread->shutting_down ) {
+      thread->has_stopped = true;
+      return;
     }
 
 
     vuu_block block;
     shared_ptr<FqElementTable> fq_table;
     vector<shared_ptr<ReductionTable>> reduction_tables;
+    CurveIteratorNormalization normalization;
+    shared_ptr<const CurveIterator> galois_reduction;
+    shared_ptr<const FactorizationPatternIterator> factorization_patterns;
 
-    thread->data_mutex.lock();
-    tie(block, fq_table, reduction_tables) =
+    tie(block, fq_table, reduction_tables, normalization, galois_reduction, factorization_patterns) =
       thread->blocks.front();
     thread->blocks.pop_front();
-    thread->data_mutex.unlock();
+    data_lock.unlock();
 
     auto store = store_factory->create();
-    for ( BlockIterator iter(block); !iter.is_end(); iter.step() ) {
-      Curve curve(fq_table, iter.as_position());
-      if ( !curve.has_squarefree_rhs() ) continue;
-      for ( auto table : reduction_tables ) curve.count(table);
-      store->register_curve(curve);
+    if ( fq_table != prefix_cache_fq_table ) {
+      prefix_cache_fq_table = fq_table;
+      prefix_cache = make_shared<CurveBlockPrefixCache>();
     }
-    store->flush_to_static_store(block);
-
 
     auto thread_pool_shared = thread->thread_pool.lock();
-    if ( thread_pool_shared )
-      thread_pool_shared->finished_block(block);
-    else {
+    if ( !thread_pool_shared ) {
       cerr << "Thread::main_thread: expired thread_pool in thread "
            << this_thread::get_id() << endl;
       throw;
     }
+
+    // curves that are enumerated by factorization patterns have no block
+    // structure and are counted one by one; otherwise each table counts with
+    // the implementation that CountAutotuner chose for it
+    vector<Curve> curves;
+    shared_ptr<CurveBlock> curve_block;
+    if ( factorization_patterns )
+      curves = factorization_patterns->curves(block);
+    else
+      curve_block = make_shared<CurveBlock>( fq_table, block, CurveBlockCountImplementationTuned,
+                                             prefix_cache, normalization, galois_reduction );
+    size_t nmb_curves = curve_block ? curve_block->size() : curves.size();
+
+    auto count = [&](unsigned int nmb_threads, const CurveChunkRunner & run_chunks) {
+      for ( auto table : reduction_tables )
+        if ( curve_block )
+          curve_block->count(table, nmb_threads, run_chunks);
+        else
+          for ( auto & curve : curves ) curve.count(table, nmb_threads, run_chunks);
+    };
+
+    // few curves leave cores idle, so we let them evaluate parts of each
+    // curve; this only pays if the largest table splits into several chunks
+    vector<shared_ptr<Thread>> borrowed_threads;
+    unsigned int max_nmb_chunks = Curve::max_nmb_chunks(*reduction_tables.back());
+    if ( !thread->is_opencl_thread() && max_nmb_chunks >= 2 )
+      borrowed_threads = thread_pool_shared->borrow_ready_threads(nmb_curves, max_nmb_chunks - 1);
+
+    if ( borrowed_threads.empty() )
+      count(1, CurveChunkRunner());
+    else {
+      // the first chunk is evaluated by this thread, the others by the
+      // borrowed ones
+      auto run_chunks = [&borrowed_threads](const vector<function<void()>> & chunks) {
+        mutex chunks_mutex;
+        condition_variable chunks_cond_var;
+        size_t nmb_pending_chunks = chunks.size() - 1;
+
+        for ( size_t cx = 1; cx < chunks.size(); ++cx )
+          borrowed_threads[(cx-1) % borrowed_threads.size()]->assign_task( [&, cx]() {
+              chunks[cx]();
+              lock_guard<mutex> chunks_lock(chunks_mutex);
+              if ( --nmb_pending_chunks == 0 )
+                chunks_cond_var.notify_one();
+            } );
+        chunks.front()();
+
+        unique_lock<mutex> chunks_lock(chunks_mutex);
+        chunks_cond_var.wait(chunks_lock, [&]() { return nmb_pending_chunks == 0; });
+      };
+
+      count(1 + borrowed_threads.size(), run_chunks);
+      thread_pool_shared->return_borrowed_threads(borrowed_threads);
+    }
+
+    if ( curve_block )
+      for ( const auto & curve : *curve_block ) store->register_curve(curve);
+    else
+      for ( const auto & curve : curves ) store->register_curve(curve);
+    store->flush_to_static_store(block);
+
+    thread_pool_shared->finished_block(block);
     thread_pool_shared.reset();
   }
 }
@@ -108,14 +181,36 @@ main_thread(
 void
 Thread::
 update_config(
-    const ConfigNode & config
+    const ConfigNode & config,
+    shared_ptr<const FactorizationPatternIterator> factorization_patterns
     )
 {
-  this->fq_table = make_shared<FqElementTable>(config.prime, config.prime_exponent);
+  // tables are shared with the other threads
+  this->fq_table = TableRegistry::fq_element_table(config.prime, config.prime_exponent);
+  this->normalization = config.projective_normalization ? CurveIteratorNormalizationProjective
+                                                        : CurveIteratorNormalizationAffine;
+  this->factorization_patterns = factorization_patterns;
+  // over prime fields, Frobenius acts trivially
+  if ( config.galois_reduction && config.prime_exponent > 1 )
+    this->galois_reduction = make_shared<const CurveIterator>(
+        *this->fq_table, config.genus, config.with_marked_point, config.package_size, this->normalization );
+  else
+    this->galois_reduction.reset();
   this->reduction_tables.clear();
-  for ( size_t fx = config.count_exponent*config.prime_exponent;
-        fx>0; fx -= config.prime_exponent )
-    this->reduction_tables.push_back(make_shared<ReductionTable>(config.prime, fx, this->opencl));
+  // counting over extensions uses counts over subfields, so we count in ascending order
+  for ( size_t fx = config.prime_exponent;
+        fx <= config.count_exponent*config.prime_exponent; fx += config.prime_exponent )
+    this->reduction_tables.push_back(TableRegistry::reduction_table(config.prime, fx, this->opencl));
+}
+
+void
+Thread::
+tune_count_variants(
+    const ConfigNode & config
+    )
+{
+  unsigned int degree = 2*config.genus + (config.with_marked_point ? 1 : 2);
+  CountAutotuner::tune(this->fq_table, this->reduction_tables, degree);
 }
 
 void
@@ -125,8 +220,31 @@ assign(
     )
 {
   this->data_mutex.lock();
-  this->blocks.emplace_back(block, this->fq_table, this->reduction_tables);
+  this->blocks.emplace_back( block, this->fq_table, this->reduction_tables,
+                             this->normalization, this->galois_reduction,
+                             this->factorization_patterns );
   this->data_mutex.unlock();
 
   this->main_cond_var.notify_one();
 }
+
+void
+Thread::
+assign_task(
+    function<void()> task
+    )
+{
+  unique_lock<mutex> data_lock(this->data_mutex);
+
+  // a thread that has been shut down does not run tasks any longer
+  if ( this->has_stopped ) {
+    data_lock.unlock();
+    task();
+    return;
+  }
+
+  this->tasks.push_back(move(task));
+  data_lock.unlock();
+
+  this->main_cond_var.notify_one();
+}
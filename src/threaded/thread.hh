@@ -26,12 +26,15 @@
 
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <tuple>
 
 #include "block_iterator.hh"
+#include "curve_iterator.hh"
+#include "factorization_pattern_iterator.hh"
 #include "fq_element_table.hh"
 #include "config/config_node.hh"
 #include "opencl/interface.hh"
@@ -42,6 +45,7 @@
 
 using std::condition_variable;
 using std::deque;
+using std::function;
 using std::mutex;
 using std::shared_ptr;
 using std::thread;
@@ -72,16 +76,27 @@ class Thread :
 
     static void main_thread(shared_ptr<Thread> thread, const shared_ptr<StoreFactoryInterface> store_factory);
   
-    void update_config(const ConfigNode & config);
+    // the iterator of factorization patterns is shared among the threads of a
+    // pool, and is empty if curves are enumerated by the curve iterator
+    void update_config( const ConfigNode & config,
+                        shared_ptr<const FactorizationPatternIterator> factorization_patterns );
+    // choose count variants for the tables of the thread, which must be
+    // called after update_config
+    void tune_count_variants(const ConfigNode & config);
     void assign(vuu_block block);
+    // a thread that is borrowed by another one runs its tasks, which take
+    // precedence over blocks
+    void assign_task(function<void()> task);
 
   private:
     weak_ptr<ThreadPool> thread_pool;
 
     thread main_std_thread;
     bool shutting_down;
+    // set by the main thread once it has returned, after which tasks are run
+    // by the threads that assign them
+    bool has_stopped;
 
-    mutex main_mutex;
     mutex data_mutex;
     condition_variable main_cond_var;
 
@@ -90,10 +105,18 @@ class Thread :
     shared_ptr<OpenCLInterface> opencl;
     shared_ptr<FqElementTable> fq_table;
     vector<shared_ptr<ReductionTable>> reduction_tables;
+    CurveIteratorNormalization normalization;
+    // the enumeration of all blocks, if curves are reduced by Frobenius
+    shared_ptr<const CurveIterator> galois_reduction;
+    // the enumeration of all blocks, if they are given by factorization patterns
+    shared_ptr<const FactorizationPatternIterator> factorization_patterns;
 
     deque<tuple< vuu_block,
-                 shared_ptr<FqElementTable>, vector<shared_ptr<ReductionTable>> >>
+                 shared_ptr<FqElementTable>, vector<shared_ptr<ReductionTable>>,
+                 CurveIteratorNormalization, shared_ptr<const CurveIterator>,
+                 shared_ptr<const FactorizationPatternIterator> >>
                    blocks;
+    deque<function<void()>> tasks;
 };
 
 #endif
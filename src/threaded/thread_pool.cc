@@ -21,12 +21,15 @@
 ===============================================================================*/
 
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
 #include <sstream>
 #include <tuple>
 
 #include "threaded/thread_pool.hh"
 #include "opencl/interface.hh"
+#include "table_registry.hh"
 
 
 using namespace std;
@@ -84,8 +87,28 @@ update_config(
     const ConfigNode & config
     )
 {
-  for ( auto & thread : this->threads )
-    thread->update_config(config);
+  // tables of earlier sections are kept within the budget, so that threads
+  // only build those that are missing
+  TableRegistry::set_retention_budget((size_t)config.table_cache_size << 20);
+
+  // the factorization patterns and their tables of irreducible polynomials
+  // are built only once for all threads
+  shared_ptr<const FactorizationPatternIterator> factorization_patterns;
+  if ( config.factorization_patterns )
+    factorization_patterns = make_shared<const FactorizationPatternIterator>(
+        TableRegistry::fq_element_table(config.prime, config.prime_exponent),
+        config.genus, config.with_marked_point, config.package_size,
+        config.ramification_types );
+
+  // cpu threads share their tables, so they are tuned only once
+  bool is_tuned = false;
+  for ( auto & thread : this->threads ) {
+    thread->update_config(config, factorization_patterns);
+    if ( !is_tuned && !thread->is_opencl_thread() ) {
+      thread->tune_count_variants(config);
+      is_tuned = true;
+    }
+  }
 }
 
 void
@@ -161,6 +184,49 @@ flush_ready_threads()
   return make_tuple(nmb_cpu_threads, nmb_opencl_threads);
 }
 
+vector<shared_ptr<Thread>>
+ThreadPool::
+borrow_ready_threads(
+    size_t nmb_curves,
+    unsigned int max_nmb_threads
+    )
+{
+  unique_lock<mutex> data_lock(this->data_mutex);
+
+  auto cpu_threads_end =
+    partition( this->ready_threads.begin(), this->ready_threads.end(),
+               [](const shared_ptr<Thread> & thread) { return thread->is_opencl_thread(); } );
+  unsigned int nmb_cpu_threads = distance(cpu_threads_end, this->ready_threads.end());
+  if ( nmb_cpu_threads <= nmb_curves )
+    return {};
+
+  auto borrowed_begin = this->ready_threads.end() - min(nmb_cpu_threads, max_nmb_threads);
+  vector<shared_ptr<Thread>> threads(borrowed_begin, this->ready_threads.end());
+  this->borrowed_threads.insert(this->borrowed_threads.end(), threads.begin(), threads.end());
+  this->ready_threads.erase(borrowed_begin, this->ready_threads.end());
+  return threads;
+}
+
+void
+ThreadPool::
+return_borrowed_threads(
+    const vector<shared_ptr<Thread>> & threads
+    )
+{
+  unique_lock<mutex> data_lock(this->data_mutex);
+
+  for ( const auto & thread : threads ) {
+    auto thread_it = find(this->borrowed_threads.begin(), this->borrowed_threads.end(), thread);
+    if ( thread_it == this->borrowed_threads.end() ) {
+      cerr << "ThreadPool::return_borrowed_threads: thread was not borrowed" << endl;
+      throw;
+    }
+
+    this->borrowed_threads.erase(thread_it);
+    this->ready_threads.push_back(thread);
+  }
+}
+
 vector<vuu_block>
 ThreadPool::
 flush_finished_blocks()
@@ -57,6 +57,12 @@ class ThreadPool :
 
     vector<vuu_block> flush_finished_blocks();
     tuple<unsigned int, unsigned int> flush_ready_threads();
+
+    // A thread whose block has fewer curves than there are ready cpu threads
+    // can borrow up to max_nmb_threads of them to run chunks of each curve.
+    // Borrowed threads are not reported as ready until they are returned.
+    vector<shared_ptr<Thread>> borrow_ready_threads(size_t nmb_curves, unsigned int max_nmb_threads);
+    void return_borrowed_threads(const vector<shared_ptr<Thread>> & threads);
     
     inline
     tuple<string, string>
@@ -73,6 +79,7 @@ class ThreadPool :
     vector<shared_ptr<Thread>> threads;
     deque<shared_ptr<Thread>> idle_threads;
     vector<shared_ptr<Thread>> ready_threads;
+    vector<shared_ptr<Thread>> borrowed_threads;
     map<vuu_block, shared_ptr<Thread>> busy_threads;
 
     vector<vuu_block> finished_blocks;
@@ -0,0 +1,79 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <curve.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+
+
+using namespace std;
+
+
+void
+bitsliced_evaluation_fq(
+    unsigned int prime_exponent,
+    unsigned int max_prime_exponent
+    )
+{
+  auto fq_table = make_shared<FqElementTable>(3, prime_exponent);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  vector<shared_ptr<ReductionTable>> reduction_tables_bitsliced;
+  for ( size_t fx = prime_exponent; fx <= max_prime_exponent; fx += prime_exponent ) {
+    reduction_tables.push_back(make_shared<ReductionTable>(3, fx));
+    reduction_tables_bitsliced.push_back(make_shared<ReductionTable>(3, fx));
+    reduction_tables_bitsliced.back()->enable_bitsliced_evaluation();
+  }
+
+  // zero coefficients are indexed by q-1
+  unsigned int zero_index = fq_table->zero_index();
+  vector<vector<unsigned int>> polys =
+      { {1,0,1,zero_index,1,1}, {zero_index,1,0,0,zero_index,zero_index,1}
+      , {0,zero_index,1,1,zero_index,0,zero_index,1} };
+
+  for ( const auto & poly : polys ) {
+    Curve curve(fq_table, poly);
+    Curve curve_bitsliced(fq_table, poly);
+    for ( auto table : reduction_tables ) curve.count(table);
+    for ( auto table : reduction_tables_bitsliced ) curve_bitsliced.count(table);
+
+    BOOST_CHECK_MESSAGE(
+        curve.number_of_points() == curve_bitsliced.number_of_points(),
+        "number of points of " << curve );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bitsliced_evaluation_f3 )
+{
+  bitsliced_evaluation_fq(1, 7);
+}
+
+BOOST_AUTO_TEST_CASE( bitsliced_evaluation_f9 )
+{
+  bitsliced_evaluation_fq(2, 6);
+}
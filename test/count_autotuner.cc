@@ -0,0 +1,67 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <count_autotuner.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+
+BOOST_AUTO_TEST_CASE( count_autotuner_profile )
+{
+  auto profile_path = fs::temp_directory_path() / fs::unique_path("hycu_count_profile_%%%%%%%%");
+  setenv("HYCU_COUNT_PROFILE", profile_path.c_str(), 1);
+
+  auto fq_table = make_shared<FqElementTable>(3, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  vector<shared_ptr<ReductionTable>> reduction_tables_cached;
+  for ( size_t fx = 1; fx <= 3; ++fx ) {
+    reduction_tables.push_back(make_shared<ReductionTable>(3, fx));
+    reduction_tables_cached.push_back(make_shared<ReductionTable>(3, fx));
+  }
+
+  CountAutotuner::tune(fq_table, reduction_tables, 5);
+  BOOST_CHECK( fs::exists(profile_path) && fs::file_size(profile_path) != 0 );
+
+  // the second calibration reuses the choices
+  CountAutotuner::tune(fq_table, reduction_tables_cached, 5);
+  for ( size_t fx = 0; fx < reduction_tables.size(); ++fx ) {
+    BOOST_CHECK( reduction_tables[fx]->count_variant() == reduction_tables_cached[fx]->count_variant() );
+    BOOST_CHECK(    reduction_tables[fx]->block_count_implementation()
+                 == reduction_tables_cached[fx]->block_count_implementation() );
+  }
+
+  unsetenv("HYCU_COUNT_PROFILE");
+  fs::remove(profile_path);
+}
@@ -0,0 +1,87 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <count_kernels.hh>
+#include <curve.hh>
+#include <evaluation_simd.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+
+
+using namespace std;
+
+
+BOOST_AUTO_TEST_CASE( count_kernels_support )
+{
+  BOOST_CHECK( count_kernel_support({6,2,6,0,1}, 6) == 0b11010 );
+
+  // no specializations for polynomials with zero leading coefficient
+  BOOST_CHECK( count_even_odd_kernel(5, 0b01010) == nullptr );
+  BOOST_CHECK( count_xs_kernel(count_kernel_max_poly_size + 1, 1u << count_kernel_max_poly_size) == nullptr );
+  BOOST_CHECK( count_tile_kernel(count_kernel_max_tail_size, 0b1010) != nullptr );
+
+  // positions of blocks may have zero leading coefficients
+  BOOST_CHECK( evaluate_values_kernel(5, 0b00110) != nullptr );
+  BOOST_CHECK( evaluate_values_kernel(count_kernel_max_poly_size + 1, 0b10) == nullptr );
+}
+
+BOOST_AUTO_TEST_CASE( count_kernels_fq_7 )
+{
+  // zero coefficients are indexed by 6, and the last polynomial exceeds the
+  // specialized sizes
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= 3; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(7, fx));
+
+  vector<vector<unsigned int>> polys =
+      { {6,0,6,6,6,1}, {2,6,6,5,6,6,3}, {1,6,4,6,6,0,6,2}
+      , {6,1,6,6,3,6,6,6,5}, {3,6,2,6,6,6,6,1,6,4} };
+
+  EvaluationSIMD simd_default = evaluation_simd();
+  set_evaluation_simd(EvaluationSIMDScalar);
+  for ( const auto & poly : polys ) {
+    // descending order evaluates at all x, ascending order at orbit representatives
+    Curve curve(fq_table, poly);
+    Curve curve_orbits(fq_table, poly);
+    Curve curve_naive(fq_table, poly);
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve.count(*table_it);
+    for ( auto table : reduction_tables ) curve_orbits.count(table);
+    for ( size_t fx = 1; fx <= reduction_tables.size(); ++fx ) curve_naive.count_naive_nmod(fx);
+
+    BOOST_CHECK_MESSAGE(
+        curve.number_of_points() == curve_naive.number_of_points(),
+        "number of points of " << curve );
+    BOOST_CHECK_MESSAGE(
+        curve_orbits.number_of_points() == curve_naive.number_of_points(),
+        "number of points via orbits of " << curve );
+  }
+  set_evaluation_simd(simd_default);
+}
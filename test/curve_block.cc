@@ -0,0 +1,355 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <curve.hh>
+#include <curve_block.hh>
+#include <evaluation_simd.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+
+
+using namespace std;
+
+
+void
+curve_block_fq_7_genus_2(
+    CurveBlockCountImplementation implementation
+    )
+{
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= 4; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(7, fx));
+
+  // this includes zero coefficients, which are indexed by 6
+  vuu_block block
+      { make_tuple(0,7), make_tuple(3,7), make_tuple(5,7)
+      , make_tuple(0,2), make_tuple(6,7), make_tuple(1,3) };
+
+  CurveBlock curve_block(fq_table, block, implementation);
+  for ( auto table : reduction_tables ) curve_block.count(table);
+  BOOST_CHECK( curve_block.size() != 0 );
+
+  for ( const auto & block_curve : curve_block ) {
+    // counting in descending order evaluates all x
+    Curve curve(fq_table, block_curve.rhs_coeff_exponents());
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve.count(*table_it);
+
+    BOOST_CHECK_MESSAGE(
+        curve.number_of_points() == block_curve.number_of_points(),
+        "number of points of " << curve );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_7_genus_2_tiled )
+{
+  curve_block_fq_7_genus_2(CurveBlockCountImplementationTiled);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_7_genus_2_tiled_lanes )
+{
+  // the tiled implementation evaluates groups of curves in vector lanes
+  EvaluationSIMD simd_default = evaluation_simd();
+  for ( auto simd : { EvaluationSIMDScalar, EvaluationSIMDAVX2, EvaluationSIMDAVX512 } ) {
+    if ( simd > simd_default ) continue;
+    set_evaluation_simd(simd);
+    curve_block_fq_7_genus_2(CurveBlockCountImplementationTiled);
+  }
+  set_evaluation_simd(simd_default);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_7_genus_2_gray_code )
+{
+  curve_block_fq_7_genus_2(CurveBlockCountImplementationGrayCode);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_7_genus_2_correlation )
+{
+  curve_block_fq_7_genus_2(CurveBlockCountImplementationCorrelation);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_7_genus_2_tuned )
+{
+  // blocks that leave the choice to the tables count as set for them
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  vuu_block block
+      { make_tuple(0,7), make_tuple(3,7), make_tuple(5,7)
+      , make_tuple(0,2), make_tuple(6,7), make_tuple(1,3) };
+
+  for ( auto implementation : { CurveBlockCountImplementationTiled,
+                                CurveBlockCountImplementationGrayCode,
+                                CurveBlockCountImplementationCorrelation } ) {
+    vector<shared_ptr<ReductionTable>> reduction_tables;
+    for ( size_t fx = 1; fx <= 3; ++fx ) {
+      reduction_tables.push_back(make_shared<ReductionTable>(7, fx));
+      reduction_tables.back()->set_block_count_implementation(implementation);
+    }
+
+    CurveBlock curve_block(fq_table, block, CurveBlockCountImplementationTuned);
+    CurveBlock curve_block_fixed(fq_table, block, implementation);
+    for ( auto table : reduction_tables ) {
+      curve_block.count(table);
+      curve_block_fixed.count(table);
+    }
+    BOOST_CHECK( curve_block.size() != 0 );
+
+    for ( auto curve_it = curve_block.begin(), curve_fixed_it = curve_block_fixed.begin();
+          curve_it != curve_block.end(); ++curve_it, ++curve_fixed_it )
+      BOOST_CHECK_MESSAGE(
+          curve_it->number_of_points() == curve_fixed_it->number_of_points(),
+          "number of points of " << *curve_it );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_correlation_zero_top_coefficients )
+{
+  // positions of the block are longer than the coefficient exponents of its curves
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= 3; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(7, fx));
+
+  vuu_block block
+      { make_tuple(0,7), make_tuple(3,5), make_tuple(5,6)
+      , make_tuple(0,2), make_tuple(6,7), make_tuple(6,7) };
+
+  CurveBlock curve_block(fq_table, block, CurveBlockCountImplementationCorrelation);
+  for ( auto table : reduction_tables ) curve_block.count(table);
+  BOOST_CHECK( curve_block.size() != 0 );
+
+  for ( const auto & block_curve : curve_block ) {
+    BOOST_CHECK( block_curve.degree() == 3 );
+
+    Curve curve(fq_table, block_curve.rhs_coeff_exponents());
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve.count(*table_it);
+
+    BOOST_CHECK_MESSAGE(
+        curve.number_of_points() == block_curve.number_of_points(),
+        "number of points of " << curve );
+  }
+}
+
+
+void
+curve_block_fq_9_genus_1(
+    CurveBlockCountImplementation implementation
+    )
+{
+  auto fq_table = make_shared<FqElementTable>(3, 2);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 2; fx <= 6; fx += 2 )
+    reduction_tables.push_back(make_shared<ReductionTable>(3, fx));
+
+  // this includes zero coefficients, which are indexed by 8
+  vuu_block block
+      { make_tuple(0,9), make_tuple(5,9), make_tuple(2,4), make_tuple(0,1) };
+
+  CurveBlock curve_block(fq_table, block, implementation);
+  for ( auto table : reduction_tables ) curve_block.count(table);
+  BOOST_CHECK( curve_block.size() != 0 );
+
+  for ( const auto & block_curve : curve_block ) {
+    // counting in descending order evaluates all x
+    Curve curve(fq_table, block_curve.rhs_coeff_exponents());
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve.count(*table_it);
+
+    BOOST_CHECK_MESSAGE(
+        curve.number_of_points() == block_curve.number_of_points(),
+        "number of points of " << curve );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_9_genus_1_tiled )
+{
+  curve_block_fq_9_genus_1(CurveBlockCountImplementationTiled);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_fq_9_genus_1_gray_code )
+{
+  curve_block_fq_9_genus_1(CurveBlockCountImplementationGrayCode);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_gray_code_correlation_kernels )
+{
+  // Gray code and correlation evaluate the positions of a block by kernels
+  // without vector instructions, and otherwise the x that do not fill a vector
+  EvaluationSIMD simd_default = evaluation_simd();
+  for ( auto simd : { EvaluationSIMDScalar, EvaluationSIMDAVX2, EvaluationSIMDAVX512 } ) {
+    if ( simd > simd_default ) continue;
+    set_evaluation_simd(simd);
+    curve_block_fq_7_genus_2(CurveBlockCountImplementationGrayCode);
+    curve_block_fq_7_genus_2(CurveBlockCountImplementationCorrelation);
+    curve_block_fq_9_genus_1(CurveBlockCountImplementationGrayCode);
+  }
+  set_evaluation_simd(simd_default);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_small_field )
+{
+  // tables of fields without kernels fall back to Gray code
+  curve_block_fq_7_genus_2(CurveBlockCountImplementationSmallField);
+  curve_block_fq_9_genus_1(CurveBlockCountImplementationSmallField);
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_prefix_cache )
+{
+  auto fq_table = make_shared<FqElementTable>(5, 1);
+  auto reduction_table = make_shared<ReductionTable>(5, 2);
+  auto prefix_cache = make_shared<CurveBlockPrefixCache>();
+
+  // two blocks that share their fixed coefficients
+  for ( unsigned int c : {0, 2} ) {
+    vuu_block block
+        { make_tuple(0,5), make_tuple(c,c+2), make_tuple(1,2)
+        , make_tuple(4,5), make_tuple(3,4), make_tuple(0,1) };
+
+    CurveBlock curve_block(fq_table, block, CurveBlockCountImplementationTiled, prefix_cache);
+    curve_block.count(reduction_table);
+
+    for ( const auto & block_curve : curve_block ) {
+      Curve curve(fq_table, block_curve.rhs_coeff_exponents());
+      curve.count(reduction_table);
+
+      BOOST_CHECK_MESSAGE(
+          curve.number_of_points() == block_curve.number_of_points(),
+          "number of points of " << curve );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_parallel )
+{
+  // the x of a curve are only split among threads for large fields
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  auto reduction_table_base = make_shared<ReductionTable>(7, 1);
+  auto reduction_table = make_shared<ReductionTable>(7, 7);
+
+  vuu_block block
+      { make_tuple(0,7), make_tuple(3,5), make_tuple(5,6)
+      , make_tuple(0,2), make_tuple(6,7), make_tuple(1,2) };
+
+  // without counts over the base field all x are evaluated, and otherwise
+  // one for each Frobenius orbit
+  for ( bool count_base : {false, true} ) {
+    CurveBlock curve_block(fq_table, block, CurveBlockCountImplementationTiled);
+    CurveBlock curve_block_parallel(fq_table, block, CurveBlockCountImplementationTiled);
+    CurveBlock curve_block_runner(fq_table, block, CurveBlockCountImplementationTiled);
+    if ( count_base ) {
+      curve_block.count(reduction_table_base);
+      curve_block_parallel.count(reduction_table_base);
+      curve_block_runner.count(reduction_table_base);
+    }
+    curve_block.count(reduction_table);
+    curve_block_parallel.count(reduction_table, 4);
+    BOOST_CHECK( curve_block.size() != 0 );
+
+    // chunks can be handed to a runner instead of threads of their own
+    size_t nmb_runs = 0;
+    curve_block_runner.count( reduction_table, 4,
+        [&nmb_runs](const vector<function<void()>> & chunks) {
+          BOOST_CHECK( chunks.size() == 4 );
+          for ( const auto & chunk : chunks ) chunk();
+          ++nmb_runs;
+        } );
+    BOOST_CHECK( nmb_runs == curve_block.size() );
+
+    for ( auto curve_it = curve_block.begin(), curve_parallel_it = curve_block_parallel.begin(),
+               curve_runner_it = curve_block_runner.begin();
+          curve_it != curve_block.end(); ++curve_it, ++curve_parallel_it, ++curve_runner_it ) {
+      BOOST_CHECK_MESSAGE(
+          curve_it->number_of_points() == curve_parallel_it->number_of_points(),
+          "number of points of " << *curve_it );
+      BOOST_CHECK_MESSAGE(
+          curve_it->number_of_points() == curve_runner_it->number_of_points(),
+          "number of points of " << *curve_it );
+    }
+  }
+
+  BOOST_CHECK( Curve::max_nmb_chunks(*reduction_table_base) == 1 );
+  BOOST_CHECK( Curve::max_nmb_chunks(*reduction_table) == (823543 - 1) / 2 / (1 << 14) );
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_squarefree )
+{
+  // in characteristic 3 some non-constant parts have vanishing derivative
+  for ( auto prime_power : { make_tuple(7,1), make_tuple(3,2) } ) {
+    auto fq_table = make_shared<FqElementTable>(get<0>(prime_power), get<1>(prime_power));
+    unsigned int prime_power_pred = get<1>(fq_table->block_non_zero());
+
+    vuu_block block
+        { fq_table->block_complete(), fq_table->block_complete(), fq_table->block_complete()
+        , fq_table->block_complete(), make_tuple(0,1) };
+    CurveBlock curve_block(fq_table, block);
+
+    set<vector<unsigned int>> block_rhss;
+    for ( const auto & curve : curve_block )
+      block_rhss.insert(curve.rhs_coeff_exponents());
+
+    set<vector<unsigned int>> rhss;
+    for ( unsigned int c0 = 0; c0 <= prime_power_pred; ++c0 )
+      for ( unsigned int c1 = 0; c1 <= prime_power_pred; ++c1 )
+        for ( unsigned int c2 = 0; c2 <= prime_power_pred; ++c2 )
+          for ( unsigned int c3 = 0; c3 <= prime_power_pred; ++c3 ) {
+            Curve curve(fq_table, {c0, c1, c2, c3, 0});
+            if ( curve.has_squarefree_rhs() )
+              rhss.insert(curve.rhs_coeff_exponents());
+          }
+
+    BOOST_CHECK( !rhss.empty() );
+    BOOST_CHECK( block_rhss == rhss );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( curve_block_ramification_type )
+{
+  // with counts over all extensions up to the degree, the ramification type
+  // is read off from them, and otherwise the right hand side is factored
+  for ( auto prime_power : { make_tuple(7,1), make_tuple(3,2) } ) {
+    auto fq_table = make_shared<FqElementTable>(get<0>(prime_power), get<1>(prime_power));
+    vuu_block block
+        { fq_table->block_complete(), make_tuple(0,2), fq_table->block_complete()
+        , make_tuple(1,3), make_tuple(3,4), make_tuple(0,1) };
+
+    CurveBlock curve_block(fq_table, block, CurveBlockCountImplementationTiled);
+    for ( unsigned int fx = 1; fx < block.size(); ++fx )
+      curve_block.count(make_shared<ReductionTable>(get<0>(prime_power), fx*get<1>(prime_power)));
+
+    for ( const auto & block_curve : curve_block ) {
+      Curve curve(fq_table, block_curve.rhs_coeff_exponents());
+      BOOST_CHECK_MESSAGE(
+          curve.ramification_type() == block_curve.ramification_type(),
+          "ramification type of " << curve );
+    }
+  }
+}
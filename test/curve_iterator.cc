@@ -27,14 +27,78 @@
 #include <tuple>
 
 #include "curve.hh"
+#include "curve_block.hh"
 #include "curve_iterator.hh"
 #include "fq_element_table.hh"
 #include "iterator_messaging.hh"
+#include "reduction_table.hh"
+#include "test_store.hh"
 
 
 using namespace std;
 
 
+// the reference stores are defined along with the threaded tests
+template <>
+TestStore<5, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+create_reference_store<5, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+template <>
+TestStore<7, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+create_reference_store<7, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+
+template<unsigned int prime_power, unsigned int genus>
+TestStore<prime_power, genus, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+normalized_store(
+    unsigned int prime,
+    unsigned int prime_exponent,
+    CurveIteratorNormalization normalization,
+    bool galois_reduction,
+    size_t & nmb_curves
+    )
+{
+  auto fq_table = make_shared<FqElementTable>(prime, prime_exponent);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= genus; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(prime, fx*prime_exponent));
+
+  TestStore<prime_power, genus, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count> store;
+  nmb_curves = 0;
+  auto iter = make_shared<CurveIterator>(*fq_table, genus, false, 100, normalization);
+  shared_ptr<const CurveIterator> galois_iter;
+  if ( galois_reduction )
+    galois_iter = make_shared<const CurveIterator>(*fq_table, genus, false, 100, normalization);
+  for (; !iter->is_end(); iter->step() ) {
+    CurveBlock curve_block( fq_table, iter->as_block(), CurveBlockCountImplementationCorrelation,
+                            shared_ptr<CurveBlockPrefixCache>(), normalization, galois_iter );
+    for ( auto table : reduction_tables ) curve_block.count(table);
+    for ( const auto & curve : curve_block ) store.register_curve(curve);
+    nmb_curves += curve_block.size();
+  }
+
+  return store;
+}
+
+template<unsigned int prime, unsigned int genus>
+void
+check_projective_normalization()
+{
+  size_t nmb_curves_affine, nmb_curves_projective;
+  normalized_store<prime,genus>(prime, 1, CurveIteratorNormalizationAffine, false, nmb_curves_affine);
+  auto computed_store = normalized_store<prime,genus>(
+      prime, 1, CurveIteratorNormalizationProjective, false, nmb_curves_projective );
+  auto reference_store = create_reference_store<prime,genus, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+  BOOST_CHECK( nmb_curves_projective < nmb_curves_affine );
+  if ( computed_store != reference_store ) {
+    stringstream message;
+    message << "Computed store differs from reference store:" << endl;
+    computed_store.insert(message);
+    BOOST_FAIL( message.str() );
+  }
+}
+
+
 BOOST_AUTO_TEST_CASE( blocks_f13_g2 )
 {
   unsigned int prime = 13;
@@ -87,3 +151,45 @@ BOOST_AUTO_TEST_CASE( blocks_f13_g2 )
   fmpz_clear(total_nmb_cmp);
   fmpz_clear(tmp);
 }
+
+BOOST_AUTO_TEST_CASE( projective_normalization_q5_g1 )
+{
+  check_projective_normalization<5,1>();
+}
+
+BOOST_AUTO_TEST_CASE( projective_normalization_q7_g1 )
+{
+  check_projective_normalization<7,1>();
+}
+
+template<unsigned int prime, unsigned int prime_exponent, unsigned int prime_power, unsigned int genus>
+void
+check_galois_reduction(
+    CurveIteratorNormalization normalization
+    )
+{
+  size_t nmb_curves, nmb_curves_reduced;
+  auto reference_store = normalized_store<prime_power,genus>(
+      prime, prime_exponent, normalization, false, nmb_curves );
+  auto computed_store = normalized_store<prime_power,genus>(
+      prime, prime_exponent, normalization, true, nmb_curves_reduced );
+
+  BOOST_CHECK( nmb_curves_reduced < nmb_curves );
+  if ( computed_store != reference_store ) {
+    stringstream message;
+    message << "Computed store differs from reference store:" << endl;
+    computed_store.insert(message);
+    BOOST_FAIL( message.str() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( galois_reduction_q9_g1 )
+{
+  check_galois_reduction<3,2,9,1>(CurveIteratorNormalizationAffine);
+  check_galois_reduction<3,2,9,1>(CurveIteratorNormalizationProjective);
+}
+
+BOOST_AUTO_TEST_CASE( galois_reduction_q25_g1 )
+{
+  check_galois_reduction<5,2,25,1>(CurveIteratorNormalizationAffine);
+}
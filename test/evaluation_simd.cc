@@ -0,0 +1,143 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <curve.hh>
+#include <evaluation_simd.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+
+
+using namespace std;
+
+
+void
+evaluation_simd_fq_7_genus_2(
+    EvaluationSIMD simd
+    )
+{
+  if ( simd > evaluation_simd() ) {
+    BOOST_TEST_MESSAGE( "instruction set not supported" );
+    return;
+  }
+
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= 4; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(7, fx));
+
+  vector<vector<unsigned int>> polys =
+      { {1,2,3,1,1,6,4}, {0,3,3,3,0,6}, {6,6,2,5,0,1}, {3,0,6,2,4,1,2} };
+
+  EvaluationSIMD simd_default = evaluation_simd();
+  for ( const auto & poly : polys ) {
+    // descending order evaluates at all x, ascending order at orbit representatives
+    Curve curve_scalar(fq_table, poly);
+    Curve curve_scalar_orbits(fq_table, poly);
+    set_evaluation_simd(EvaluationSIMDScalar);
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve_scalar.count(*table_it);
+    for ( auto table : reduction_tables ) curve_scalar_orbits.count(table);
+
+    Curve curve_simd(fq_table, poly);
+    Curve curve_simd_orbits(fq_table, poly);
+    set_evaluation_simd(simd);
+    for ( auto table_it = reduction_tables.rbegin(); table_it != reduction_tables.rend(); ++table_it )
+      curve_simd.count(*table_it);
+    for ( auto table : reduction_tables ) curve_simd_orbits.count(table);
+
+    BOOST_CHECK_MESSAGE(
+        curve_scalar.number_of_points() == curve_simd.number_of_points(),
+        "number of points of " << curve_scalar );
+    BOOST_CHECK_MESSAGE(
+        curve_scalar_orbits.number_of_points() == curve_simd_orbits.number_of_points(),
+        "number of points via orbits of " << curve_scalar );
+    BOOST_CHECK_MESSAGE(
+        curve_scalar.number_of_points() == curve_simd_orbits.number_of_points(),
+        "number of points via orbits of " << curve_scalar );
+  }
+  set_evaluation_simd(simd_default);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_simd_fq_7_genus_2_avx2 )
+{
+  evaluation_simd_fq_7_genus_2(EvaluationSIMDAVX2);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_simd_fq_7_genus_2_avx512 )
+{
+  evaluation_simd_fq_7_genus_2(EvaluationSIMDAVX512);
+}
+
+void
+evaluation_simd_prime_field(
+    EvaluationSIMD simd
+    )
+{
+  if ( simd > evaluation_simd() ) {
+    BOOST_TEST_MESSAGE( "instruction set not supported" );
+    return;
+  }
+
+  EvaluationSIMD simd_default = evaluation_simd();
+  for ( unsigned int prime : {101, 1009, 65521} ) {
+    auto fq_table = make_shared<FqElementTable>(prime, 1);
+    auto reduction_table = make_shared<ReductionTable>(prime, 1);
+
+    vector<vector<unsigned int>> polys =
+        { {1,2,3,1,1,prime-1,4}, {prime-1,3,3,3,prime-1,6}, {7,prime-1,prime/2,prime-3,2,1,prime/3,5} };
+
+    for ( const auto & poly : polys ) {
+      Curve curve(fq_table, poly);
+      Curve curve_prime_field(fq_table, poly);
+      set_evaluation_simd(simd);
+      curve.count(reduction_table);
+      curve_prime_field.count_prime_field();
+
+      BOOST_CHECK_MESSAGE(
+          curve.number_of_points() == curve_prime_field.number_of_points(),
+          "number of points over the prime field of " << curve );
+    }
+  }
+  set_evaluation_simd(simd_default);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_simd_prime_field_scalar )
+{
+  evaluation_simd_prime_field(EvaluationSIMDScalar);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_simd_prime_field_avx2 )
+{
+  evaluation_simd_prime_field(EvaluationSIMDAVX2);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_simd_prime_field_avx512 )
+{
+  evaluation_simd_prime_field(EvaluationSIMDAVX512);
+}
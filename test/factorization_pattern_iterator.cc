@@ -0,0 +1,159 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <factorization_pattern_iterator.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+#include "test_store.hh"
+
+
+using namespace std;
+
+
+// the reference stores are defined along with the threaded tests
+template <>
+TestStore<5, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+create_reference_store<5, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+template <>
+TestStore<7, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+create_reference_store<7, 1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+template <>
+TestStore<7, 2, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+create_reference_store<7, 2, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+
+template<unsigned int prime, unsigned int genus>
+TestStore<prime, genus, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>
+factorization_pattern_store(
+    const set<vector<unsigned int>> & ramification_types = {},
+    unsigned int package_size = 100
+    )
+{
+  auto fq_table = make_shared<FqElementTable>(prime, 1);
+  vector<shared_ptr<ReductionTable>> reduction_tables;
+  for ( size_t fx = 1; fx <= genus; ++fx )
+    reduction_tables.push_back(make_shared<ReductionTable>(prime, fx));
+
+  TestStore<prime, genus, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count> store;
+  FactorizationPatternIterator iter(fq_table, genus, false, package_size, ramification_types);
+  for (; !iter.is_end(); iter.step() )
+    for ( auto curve : iter.as_curves() ) {
+      BOOST_CHECK( curve.has_squarefree_rhs() );
+      for ( auto table : reduction_tables ) curve.count(table);
+      store.register_curve(curve);
+    }
+
+  return store;
+}
+
+BOOST_AUTO_TEST_CASE( factorization_pattern_q5_g1 )
+{
+  auto computed_store = factorization_pattern_store<5,1>();
+  auto reference_store = create_reference_store<5,1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+  if ( computed_store != reference_store ) {
+    stringstream message;
+    message << "Computed store differs from reference store:" << endl;
+    computed_store.insert(message);
+    BOOST_FAIL( message.str() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( factorization_pattern_q7_g1 )
+{
+  auto computed_store = factorization_pattern_store<7,1>();
+  auto reference_store = create_reference_store<7,1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+  if ( computed_store != reference_store ) {
+    stringstream message;
+    message << "Computed store differs from reference store:" << endl;
+    computed_store.insert(message);
+    BOOST_FAIL( message.str() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( factorization_pattern_q7_g2 )
+{
+  auto computed_store = factorization_pattern_store<7,2>();
+  auto reference_store = create_reference_store<7,2, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+
+  if ( computed_store != reference_store ) {
+    stringstream message;
+    message << "Computed store differs from reference store:" << endl;
+    computed_store.insert(message);
+    BOOST_FAIL( message.str() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( factorization_pattern_blocks )
+{
+  // the curves do not depend on how they are split into blocks
+  auto computed_store = factorization_pattern_store<5,1>({}, 3);
+  auto reference_store = create_reference_store<5,1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>();
+  BOOST_CHECK( !(computed_store != reference_store) );
+
+  // blocks are reproduced by other iterators, as they are on threads
+  auto fq_table = make_shared<FqElementTable>(7, 1);
+  FactorizationPatternIterator iter(fq_table, 1, false, 20);
+  FactorizationPatternIterator iter_curves(fq_table, 1, false, 20);
+  size_t nmb_curves = 0;
+  for (; !iter.is_end(); iter.step() ) {
+    auto curves = iter.as_curves();
+    auto curves_reproduced = iter_curves.curves(iter.as_block());
+    BOOST_REQUIRE( curves.size() == curves_reproduced.size() );
+    for ( size_t cx = 0; cx < curves.size(); ++cx )
+      BOOST_CHECK( curves[cx].rhs_coeff_exponents() == curves_reproduced[cx].rhs_coeff_exponents() );
+    nmb_curves += curves.size();
+  }
+
+  // one right hand side is enumerated for each orbit under affine
+  // substitutions, which is far fewer than the 7^4 - 7^2 monic squarefree ones
+  // of degree 3 and 4
+  BOOST_CHECK( nmb_curves < (7*7*7*7 - 7*7) / 7 );
+}
+
+BOOST_AUTO_TEST_CASE( factorization_pattern_ramification_types )
+{
+  // a restricted run yields the part of the store for these ramification types
+  set<vector<unsigned int>> ramification_types { {1,3}, {2,2} };
+  auto computed_store = factorization_pattern_store<5,1>(ramification_types);
+
+  stringstream computed, reference;
+  computed_store.insert(computed);
+  create_reference_store<5,1, HyCu::CurveData::ExplicitRamificationHasseWeil, HyCu::StoreData::Count>()
+    .insert(reference);
+
+  string reference_restricted;
+  for ( string line; getline(reference, line); )
+    if ( line.find("1,3;") == 0 || line.find("2,2;") == 0 )
+      reference_restricted += line + "\n";
+
+  BOOST_CHECK( !reference_restricted.empty() );
+  BOOST_CHECK_EQUAL( computed.str(), reference_restricted );
+}
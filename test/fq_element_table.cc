@@ -0,0 +1,84 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+#include <boost/test/unit_test.hpp>
+
+#include <flint/fq_nmod.h>
+#include <tuple>
+
+#include "fq_element_table.hh"
+
+
+using namespace std;
+
+
+BOOST_AUTO_TEST_CASE( fq_element_table_elements )
+{
+  for ( auto prime_power : { make_tuple(7,1), make_tuple(3,4), make_tuple(7,2) } ) {
+    unsigned int prime = get<0>(prime_power);
+    unsigned int prime_exponent = get<1>(prime_power);
+    FqElementTable table(prime, prime_exponent);
+    unsigned int prime_power_pred = get<1>(table.block_non_zero());
+
+    // one label and one index per element, independently of the exponent
+    BOOST_CHECK( table.memory_size() <= (prime_power_pred + 1) * 2 * sizeof(uint32_t) + prime / 8 + 4 );
+
+    fmpz_t prime_fmpz;
+    fmpz_init_set_ui(prime_fmpz, prime);
+    fq_nmod_ctx_t fq_ctx;
+    fq_nmod_ctx_init(fq_ctx, prime_fmpz, prime_exponent, "T");
+    fmpz_clear(prime_fmpz);
+
+    fq_nmod_t a, b, c, gen;
+    fq_nmod_init(a, fq_ctx);
+    fq_nmod_init(b, fq_ctx);
+    fq_nmod_init(c, fq_ctx);
+    fq_nmod_init(gen, fq_ctx);
+
+    table.element(a, table.zero_index());
+    BOOST_CHECK( fq_nmod_is_zero(a, fq_ctx) );
+    BOOST_CHECK( table.index(a) == table.zero_index() );
+
+    table.element(a, 0);
+    BOOST_CHECK( fq_nmod_is_one(a, fq_ctx) );
+
+    // the element at index i is the i-th power of a generator
+    table.element(gen, 1);
+    for ( unsigned int ix = 0; ix < prime_power_pred; ++ix ) {
+      table.element(b, ix);
+      BOOST_CHECK( fq_nmod_equal(a, b, fq_ctx) );
+      BOOST_CHECK( table.index(b) == ix );
+      BOOST_CHECK( table.at_nmod(ix) == nmod_poly_get_coeff_ui(b, 0) );
+
+      fq_nmod_mul(c, a, gen, fq_ctx);
+      fq_nmod_swap(a, c, fq_ctx);
+      if ( ix + 1 < prime_power_pred )
+        BOOST_CHECK( !fq_nmod_is_one(a, fq_ctx) );
+    }
+    BOOST_CHECK( fq_nmod_is_one(a, fq_ctx) );
+
+    fq_nmod_clear(a, fq_ctx);
+    fq_nmod_clear(b, fq_ctx);
+    fq_nmod_clear(c, fq_ctx);
+    fq_nmod_clear(gen, fq_ctx);
+    fq_nmod_ctx_clear(fq_ctx);
+  }
+}
@@ -0,0 +1,47 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+#include "curve.hh"
+#include "fq_element_table.hh"
+#include "reduction_table.hh"
+
+
+using namespace std;
+
+
+BOOST_AUTO_TEST_CASE( reduction_table_logarithms_chunked )
+{
+  // for large fields the powers of the generator are walked in several chunks
+  auto fq_table = make_shared<FqElementTable>(3, 1);
+  auto reduction_table = make_shared<ReductionTable>(3, 10);
+
+  Curve curve(fq_table, {0,1,2,0});
+  Curve curve_naive(fq_table, {0,1,2,0});
+  BOOST_REQUIRE( curve.has_squarefree_rhs() );
+
+  curve.count(reduction_table);
+  curve_naive.count_naive_nmod(10);
+  BOOST_CHECK( curve.number_of_points() == curve_naive.number_of_points() );
+}
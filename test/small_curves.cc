@@ -70,6 +70,11 @@ BOOST_AUTO_TEST_CASE( fq_5_curve_1_2_3_1_1_0_4_cpu )
   fq_5_curve_1_2_3_1_1_0_4(SingleCurveCountImplementationCPU);
 }
 
+BOOST_AUTO_TEST_CASE( fq_5_curve_1_2_3_1_1_0_4_primefield )
+{
+  fq_5_curve_1_2_3_1_1_0_4(SingleCurveCountImplementationPrimeField);
+}
+
 BOOST_AUTO_TEST_CASE( fq_5_curve_1_2_3_1_1_0_4_naivenmod )
 {
   fq_5_curve_1_2_3_1_1_0_4(SingleCurveCountImplementationNaiveNMod);
@@ -120,6 +125,11 @@ BOOST_AUTO_TEST_CASE( fq_7_curve_0_3_3_3_0_6_cpu )
   fq_7_curve_0_3_3_3_0_6(SingleCurveCountImplementationCPU);
 }
 
+BOOST_AUTO_TEST_CASE( fq_7_curve_0_3_3_3_0_6_primefield )
+{
+  fq_7_curve_0_3_3_3_0_6(SingleCurveCountImplementationPrimeField);
+}
+
 BOOST_AUTO_TEST_CASE( fq_7_curve_0_3_3_3_0_6_naivenmod )
 {
   fq_7_curve_0_3_3_3_0_6(SingleCurveCountImplementationNaiveNMod);
@@ -0,0 +1,98 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <curve.hh>
+#include <fq_element_table.hh>
+#include <reduction_table.hh>
+#include <small_field_kernels.hh>
+
+
+using namespace std;
+
+
+BOOST_AUTO_TEST_CASE( small_field_kernels_availability )
+{
+  MappedTable<int32_t> incrementation_table(vector<int32_t>(256, 0));
+  BOOST_CHECK( small_field_kernel(3, 6, incrementation_table) == nullptr );
+  BOOST_CHECK( small_field_kernel(257, 1, incrementation_table) == nullptr );
+  BOOST_CHECK( small_field_kernel(17, 2, incrementation_table) == nullptr );
+  // tables with respect to another generator are rejected
+  BOOST_CHECK( small_field_kernel(7, 1, incrementation_table) == nullptr );
+  BOOST_CHECK( small_field_kernel(3, 2, incrementation_table) == nullptr );
+}
+
+BOOST_AUTO_TEST_CASE( small_field_kernels_fp )
+{
+  for ( unsigned int prime : {11, 13, 61, 251} ) {
+    auto fq_table = make_shared<FqElementTable>(prime, 1);
+    auto reduction_table = make_shared<ReductionTable>(prime, 1);
+    unsigned int zero_index = prime - 1;
+
+    vector<vector<unsigned int>> polys =
+        { {1,2,3,1,1,0,4}, {zero_index,3,3,3,zero_index,6}, {7,zero_index,5,zero_index,2,1} };
+
+    for ( const auto & poly : polys ) {
+      Curve curve(fq_table, poly);
+      Curve curve_naive(fq_table, poly);
+      curve.count(reduction_table);
+      curve_naive.count_naive_nmod(1);
+
+      BOOST_CHECK_MESSAGE(
+          curve.number_of_points() == curve_naive.number_of_points(),
+          "number of points of " << curve );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( small_field_kernels_fq )
+{
+  // extension fields whose kernels use the Conway polynomial
+  for ( auto prime_power : { make_tuple(3,2), make_tuple(3,5), make_tuple(5,3), make_tuple(7,2), make_tuple(13,2) } ) {
+    unsigned int prime = get<0>(prime_power);
+    unsigned int prime_exponent = get<1>(prime_power);
+    auto fq_table = make_shared<FqElementTable>(prime, prime_exponent);
+    auto reduction_table = make_shared<ReductionTable>(prime, prime_exponent);
+    unsigned int zero_index = get<1>(fq_table->block_non_zero());
+
+    vector<vector<unsigned int>> polys =
+        { {1,2,3,1,1,0,4}, {zero_index,3,3,3,zero_index,6}, {7,zero_index,5,zero_index,2,1} };
+
+    for ( const auto & poly : polys ) {
+      Curve curve(fq_table, poly);
+      Curve curve_naive(fq_table, poly);
+      curve.count(reduction_table);
+      curve_naive.count_naive_nmod(prime_exponent);
+
+      BOOST_CHECK_MESSAGE(
+          curve.number_of_points() == curve_naive.number_of_points(),
+          "number of points of " << curve );
+    }
+  }
+}
@@ -0,0 +1,91 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "curve.hh"
+#include "fq_element_table.hh"
+#include "reduction_table.hh"
+#include "table_cache.hh"
+
+
+using namespace std;
+using boost::filesystem::directory_iterator;
+using boost::filesystem::path;
+using boost::filesystem::remove_all;
+using boost::filesystem::temp_directory_path;
+using boost::filesystem::unique_path;
+
+
+BOOST_AUTO_TEST_CASE( table_cache_logarithms )
+{
+  path cache_path = temp_directory_path() / unique_path("hycu-table-cache-%%%%-%%%%");
+  setenv("HYCU_TABLE_CACHE", cache_path.c_str(), 1);
+
+  // the first tables are computed and written, the second ones are read
+  for ( auto prime_power : { make_tuple(5,2), make_tuple(3,4) } ) {
+    unsigned int prime = get<0>(prime_power);
+    unsigned int prime_exponent = get<1>(prime_power);
+
+    auto fq_table = make_shared<FqElementTable>(prime, prime_exponent);
+    auto fq_table_cached = make_shared<FqElementTable>(prime, prime_exponent);
+    auto reduction_table = make_shared<ReductionTable>(prime, prime_exponent);
+    auto reduction_table_cached = make_shared<ReductionTable>(prime, prime_exponent);
+
+    fmpz_t prime_fmpz;
+    fmpz_init_set_ui(prime_fmpz, prime);
+    fq_nmod_ctx_t fq_ctx;
+    fq_nmod_ctx_init(fq_ctx, prime_fmpz, prime_exponent, "T");
+    fmpz_clear(prime_fmpz);
+
+    fq_nmod_t a;
+    fq_nmod_init(a, fq_ctx);
+    for ( unsigned int ix = 0; ix < get<1>(fq_table->block_complete()); ++ix ) {
+      fq_table->element(a, ix);
+      BOOST_CHECK( fq_table_cached->index(a) == ix );
+    }
+    fq_nmod_clear(a, fq_ctx);
+    fq_nmod_ctx_clear(fq_ctx);
+
+    Curve curve(fq_table, {0,1,2,5,0});
+    Curve curve_cached(fq_table_cached, {0,1,2,5,0});
+    BOOST_REQUIRE( curve.has_squarefree_rhs() );
+    curve.count(reduction_table);
+    curve_cached.count(reduction_table_cached);
+    BOOST_CHECK( curve.number_of_points() == curve_cached.number_of_points() );
+  }
+
+  BOOST_CHECK( !boost::filesystem::is_empty(cache_path) );
+  // the tables derived from the logarithm tables are cached as well
+  for ( string name : { "logarithms", "labels", "incrementations", "compact_zech", "additive", "additive_inverse" } ) {
+    bool is_cached = false;
+    for ( const auto & entry : directory_iterator(cache_path) )
+      is_cached = is_cached || entry.path().filename().string().find(name + "_5_2.") == 0;
+    BOOST_CHECK( is_cached );
+  }
+  unsetenv("HYCU_TABLE_CACHE");
+  remove_all(cache_path);
+}
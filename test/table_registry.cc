@@ -0,0 +1,89 @@
+/*============================================================================
+
+    (C) 2016 Martin Westerholt-Raum
+
+    This file is part of HyCu.
+
+    HyCu is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    HyCu is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with HyCu; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+===============================================================================*/
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+#include "table_registry.hh"
+
+
+using namespace std;
+
+
+BOOST_AUTO_TEST_CASE( table_registry_sharing )
+{
+  TableRegistry::set_retention_budget(0);
+
+  auto fq_table = TableRegistry::fq_element_table(7, 2);
+  BOOST_CHECK( TableRegistry::fq_element_table(7, 2) == fq_table );
+  BOOST_CHECK( TableRegistry::fq_element_table(7, 1) != fq_table );
+
+  auto reduction_table = TableRegistry::reduction_table(7, 2);
+  BOOST_CHECK( TableRegistry::reduction_table(7, 2) == reduction_table );
+  BOOST_CHECK( TableRegistry::reduction_table(5, 2) != reduction_table );
+
+  // tables that nobody holds are released
+  weak_ptr<ReductionTable> reduction_table_weak = reduction_table;
+  reduction_table.reset();
+  BOOST_CHECK( reduction_table_weak.expired() );
+}
+
+BOOST_AUTO_TEST_CASE( table_registry_retention )
+{
+  size_t size_7_2 = TableRegistry::reduction_table(7, 2)->memory_size();
+  size_t size_7_3 = TableRegistry::reduction_table(7, 3)->memory_size();
+  TableRegistry::set_retention_budget(size_7_2 + size_7_3);
+
+  weak_ptr<ReductionTable> reduction_table_7_2 = TableRegistry::reduction_table(7, 2);
+  weak_ptr<ReductionTable> reduction_table_7_3 = TableRegistry::reduction_table(7, 3);
+  BOOST_CHECK( !reduction_table_7_2.expired() );
+  BOOST_CHECK( !reduction_table_7_3.expired() );
+  BOOST_CHECK( TableRegistry::retained_memory_size() == size_7_2 + size_7_3 );
+
+  // requesting 7^2 again makes 7^3 the least recently used table
+  BOOST_CHECK( TableRegistry::reduction_table(7, 2) == reduction_table_7_2.lock() );
+  weak_ptr<ReductionTable> reduction_table_7_1 = TableRegistry::reduction_table(7, 1);
+  BOOST_CHECK( !reduction_table_7_2.expired() );
+  BOOST_CHECK( reduction_table_7_3.expired() );
+  BOOST_CHECK( TableRegistry::retained_memory_size() <= size_7_2 + size_7_3 );
+
+  TableRegistry::set_retention_budget(0);
+  BOOST_CHECK( reduction_table_7_1.expired() );
+  BOOST_CHECK( reduction_table_7_2.expired() );
+  BOOST_CHECK( TableRegistry::retained_memory_size() == 0 );
+}
+
+BOOST_AUTO_TEST_CASE( table_registry_lazy_memory )
+{
+  TableRegistry::set_retention_budget(size_t(1) << 30);
+
+  auto reduction_table = TableRegistry::reduction_table(3, 2);
+  size_t size = TableRegistry::retained_memory_size();
+  BOOST_CHECK( size == reduction_table->memory_size() );
+
+  // the bitsliced evaluation is built only when it is selected
+  reduction_table->set_count_variant(CountVariantBitsliced);
+  BOOST_CHECK( reduction_table->memory_size() > size );
+  BOOST_CHECK( TableRegistry::retained_memory_size() == reduction_table->memory_size() );
+
+  TableRegistry::set_retention_budget(0);
+}